@@ -28,6 +28,7 @@
 #include "FWCore/Framework/interface/MakerMacros.h"
 
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
 
 #include "DataFormats/EcalDigi/interface/EcalDigiCollections.h"
 #include "DataFormats/HcalDigi/interface/HcalDigiCollections.h"
@@ -40,7 +41,21 @@
 
 #include "L1Trigger/L1TCaloLayer1/src/UCTGeometry.hh"
 
+#include "L1Trigger/L1TCaloLayer1/src/UCTLinkPacker.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTCalibrationLUT.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTChannelMask.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTThresholdScan.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTRegionCounters.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTGlobalSums.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTSummaryCard.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTPileupEstimator.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTMetrics.hh"
+
 #include "DataFormats/L1TCalorimeter/interface/CaloTower.h"
+#include "DataFormats/L1Trigger/interface/EtSum.h"
+#include "DataFormats/L1Trigger/interface/Jet.h"
+#include "DataFormats/L1Trigger/interface/EGamma.h"
+#include "DataFormats/L1Trigger/interface/Tau.h"
 
 using namespace l1t;
 
@@ -60,13 +75,20 @@ private:
   virtual void produce(edm::Event&, const edm::EventSetup&) override;
   virtual void endJob() override;
       
-  //virtual void beginRun(edm::Run const&, edm::EventSetup const&) override;
-  //virtual void endRun(edm::Run const&, edm::EventSetup const&) override;
+  virtual void beginRun(edm::Run const&, edm::EventSetup const&) override;
+  virtual void endRun(edm::Run const&, edm::EventSetup const&) override;
   //virtual void beginLuminosityBlock(edm::LuminosityBlock const&, edm::EventSetup const&) override;
   //virtual void endLuminosityBlock(edm::LuminosityBlock const&, edm::EventSetup const&) override;
 
   void print();
 
+  void putSums(edm::Event& iEvent, const UCTEtSums& sums, const std::string& label);
+  void putSummaryObjects(edm::Event& iEvent);
+
+  void defineMetrics(uint32_t interval);
+  void fillMetrics(uint64_t start, uint64_t inputDone, uint64_t processDone,
+		   uint32_t saturatedTowers, uint32_t saturatedRegions);
+
   // ----------member data ---------------------------
 
   edm::EDGetTokenT<EcalTrigPrimDigiCollection> ecalTPSource;
@@ -75,9 +97,60 @@ private:
   std::string hcalTPSourceLabel;
 
   bool verbose;
+  bool packLinks;
+  std::string calibrationLUTFile;
+  std::string channelMaskFile;
+  bool produceGlobalSums;
+  bool produceSummaryCard;
+  bool estimatePileup;
 
   UCTLayer1 *layer1;
 
+  // TP arrays for bulk loading, reused from event to event
+
+  std::vector<int> ecalEta;
+  std::vector<int> ecalPhi;
+  std::vector<uint32_t> ecalET;
+  std::vector<uint32_t> ecalFG;
+  std::vector<int> hcalEta;
+  std::vector<int> hcalPhi;
+  std::vector<uint32_t> hcalET;
+  std::vector<uint32_t> hcalFB;
+  UCTLinkPacker *linkPacker;
+
+  UCTCalibrationLUT calibrationLUT;
+
+  UCTChannelMask channelMask;
+  uint64_t maskedECALET;
+  uint64_t maskedHCALET;
+
+  UCTThresholdScan *thresholdScan;
+
+  UCTRegionCounters *regionCounters;
+
+  UCTGlobalSums *globalSums;
+
+  UCTSummaryCard *summaryCard;
+
+  UCTPileupEstimator *pileupEstimator;
+
+  // Optional Prometheus textfile metrics, see UCTMetrics.hh
+
+  std::string metricsFile;
+  UCTMetrics *metrics;
+  uint32_t eventsMetric;
+  uint32_t inputTimeMetric;
+  uint32_t processTimeMetric;
+  uint32_t outputTimeMetric;
+  uint32_t latencyMetric;
+  uint32_t saturatedTowersMetric;
+  uint32_t saturatedRegionsMetric;
+  uint32_t maskedECALMetric;
+  uint32_t maskedHCALMetric;
+  uint32_t regionsMetric;
+  uint32_t egLikeRegionsMetric;
+  uint32_t tauLikeRegionsMetric;
+
 };
 
 //
@@ -97,13 +170,84 @@ L1TCaloLayer1::L1TCaloLayer1(const edm::ParameterSet& iConfig) :
   ecalTPSourceLabel(iConfig.getParameter<edm::InputTag>("ecalTPSource").label()),
   hcalTPSource(consumes<HcalTrigPrimDigiCollection>(iConfig.getParameter<edm::InputTag>("hcalTPSource"))),
   hcalTPSourceLabel(iConfig.getParameter<edm::InputTag>("hcalTPSource").label()),
-  verbose(iConfig.getParameter<bool>("verbose")) 
+  verbose(iConfig.getParameter<bool>("verbose")),
+  packLinks(iConfig.getParameter<bool>("packLinks")),
+  calibrationLUTFile(iConfig.getParameter<std::string>("calibrationLUTFile")),
+  channelMaskFile(iConfig.getParameter<std::string>("channelMaskFile")),
+  produceGlobalSums(iConfig.getParameter<bool>("produceGlobalSums")),
+  produceSummaryCard(iConfig.getParameter<bool>("produceSummaryCard")),
+  estimatePileup(iConfig.getParameter<bool>("estimatePileup")),
+  linkPacker(0),
+  maskedECALET(0),
+  maskedHCALET(0),
+  thresholdScan(0),
+  regionCounters(0),
+  globalSums(0),
+  summaryCard(0),
+  pileupEstimator(0),
+  metricsFile(iConfig.getParameter<std::string>("metricsFile")),
+  metrics(0)
 {
   produces<CaloTowerBxCollection>();
   layer1 = new UCTLayer1;
+  regionCounters = new UCTRegionCounters(*layer1);
+  if(packLinks) {
+    // Hardware ordered CTP7 output link words, see UCTLinkPacker.hh for the layout
+    produces<std::vector<uint16_t> >("ctp7Links");
+    linkPacker = new UCTLinkPacker(*layer1);
+  }
+  if(produceGlobalSums) {
+    // ET, HT, MET and MHT at tower and at region granularity
+    produces<EtSumBxCollection>("towerSums");
+    produces<EtSumBxCollection>("regionSums");
+    globalSums = new UCTGlobalSums(*layer1, 
+				   iConfig.getParameter<unsigned int>("towerHTThreshold"),
+				   iConfig.getParameter<unsigned int>("regionHTThreshold"));
+  }
+  if(produceSummaryCard) {
+    // Jet, EG and tau candidates of the summary card, at region granularity
+    produces<JetBxCollection>();
+    produces<EGammaBxCollection>();
+    produces<TauBxCollection>();
+    summaryCard = new UCTSummaryCard(*layer1);
+    UCTSummaryThresholds t;
+    t.jetSeed = iConfig.getParameter<unsigned int>("summaryJetSeed");
+    t.egSeed = iConfig.getParameter<unsigned int>("summaryEGSeed");
+    t.tauSeed = iConfig.getParameter<unsigned int>("summaryTauSeed");
+    t.isolationFraction = iConfig.getParameter<double>("summaryIsolationFraction");
+    summaryCard->setThresholds(t);
+  }
+  if(estimatePileup) {
+    // Running average ET per region eta ring (-13 to 13) and per tower eta ring (-41 to 41)
+    produces<std::vector<float> >("regionRingPileup");
+    produces<std::vector<float> >("towerRingPileup");
+    pileupEstimator = new UCTPileupEstimator(*layer1, iConfig.getParameter<unsigned int>("pileupAverageShift"));
+  }
+  // Optional region veto threshold scan, summarized at the end of the job
+  std::vector<edm::ParameterSet> scanPSets = 
+    iConfig.getParameter<std::vector<edm::ParameterSet> >("regionThresholdScan");
+  if(scanPSets.size() > 0) {
+    std::vector<UCTRegionThresholds> thresholds;
+    for(uint32_t i = 0; i < scanPSets.size(); i++) {
+      UCTRegionThresholds t;
+      t.activityFraction = scanPSets[i].getParameter<double>("activityFraction");
+      t.ecalActivityFraction = scanPSets[i].getParameter<double>("ecalActivityFraction");
+      t.miscActivityFraction = scanPSets[i].getParameter<double>("miscActivityFraction");
+      thresholds.push_back(t);
+    }
+    thresholdScan = new UCTThresholdScan(*layer1, thresholds);
+  }
+  if(!metricsFile.empty()) defineMetrics(iConfig.getParameter<unsigned int>("metricsInterval"));
 }
 
 L1TCaloLayer1::~L1TCaloLayer1() {
+  if(metrics != 0) delete metrics;
+  if(pileupEstimator != 0) delete pileupEstimator;
+  if(summaryCard != 0) delete summaryCard;
+  if(globalSums != 0) delete globalSums;
+  if(thresholdScan != 0) delete thresholdScan;
+  if(regionCounters != 0) delete regionCounters;
+  if(linkPacker != 0) delete linkPacker;
   if(layer1 != 0) delete layer1;
 }
 
@@ -117,6 +261,8 @@ L1TCaloLayer1::produce(edm::Event& iEvent, const edm::EventSetup& iSetup)
 {
   using namespace edm;
 
+  uint64_t start = (metrics != 0 ? UCTMetrics::now() : 0);
+
   edm::Handle<EcalTrigPrimDigiCollection> ecalTPs;
   iEvent.getByToken(ecalTPSource, ecalTPs);
   edm::Handle<HcalTrigPrimDigiCollection> hcalTPs;
@@ -130,44 +276,63 @@ L1TCaloLayer1::produce(edm::Event& iEvent, const edm::EventSetup& iSetup)
     return;
   }
 
+  // Gather the TPs into arrays in one pass; zero suppression and
+  // grouping by card is done by the bulk setters of UCTLayer1
+
+  uint32_t nECALTPs = 0;
+  ecalEta.resize(ecalTPs->size());
+  ecalPhi.resize(ecalTPs->size());
+  ecalET.resize(ecalTPs->size());
+  ecalFG.resize(ecalTPs->size());
   for ( const auto& ecalTp : *ecalTPs ) {
-    int caloEta = ecalTp.id().ieta();
-    int caloPhi = ecalTp.id().iphi();
-    int et = ecalTp.compressedEt();
-    bool fgVeto = ecalTp.fineGrain();
-    if(et != 0) {
-      UCTTowerIndex t = UCTTowerIndex(caloEta, caloPhi);
-      if(!layer1->setECALData(t,fgVeto,et)) {
-	std::cerr << "UCT: Failed loading an ECAL tower" << std::endl;
-	return;
-      }
-      expectedTotalET += et;
-    }
+    ecalEta[nECALTPs] = ecalTp.id().ieta();
+    ecalPhi[nECALTPs] = ecalTp.id().iphi();
+    ecalET[nECALTPs] = ecalTp.compressedEt();
+    ecalFG[nECALTPs] = ecalTp.fineGrain();
+    expectedTotalET += ecalET[nECALTPs];
+    nECALTPs++;
+  }
+  if(nECALTPs > 0 && 
+     !layer1->setECALData(&ecalEta[0], &ecalPhi[0], &ecalET[0], &ecalFG[0], nECALTPs)) {
+    std::cerr << "UCT: Failed loading ECAL towers" << std::endl;
+    return;
   }
 
+  uint32_t nHCALTPs = 0;
+  hcalEta.resize(hcalTPs->size());
+  hcalPhi.resize(hcalTPs->size());
+  hcalET.resize(hcalTPs->size());
+  hcalFB.resize(hcalTPs->size());
   for ( const auto& hcalTp : *hcalTPs ) {
-    int caloEta = hcalTp.id().ieta();
-    int caloPhi = hcalTp.id().iphi();
-    int et = hcalTp.SOI_compressedEt();
-    bool fg = hcalTp.SOI_fineGrain();
-    if(et != 0) {
-      UCTTowerIndex t = UCTTowerIndex(caloEta, caloPhi);
-      uint32_t featureBits = 0;
-      if(fg) featureBits = 0x1F; // Set all five feature bits for the moment - they are not defined in HW / FW yet!
-      if(!layer1->setHCALData(t, et, featureBits)) {
-	std::cerr << "UCT: Failed loading an HCAL tower" << std::endl;
-	return;
-
-      }
-      expectedTotalET += et;
-    }
+    hcalEta[nHCALTPs] = hcalTp.id().ieta();
+    hcalPhi[nHCALTPs] = hcalTp.id().iphi();
+    hcalET[nHCALTPs] = hcalTp.SOI_compressedEt();
+    // Set all five feature bits for the moment - they are not defined in HW / FW yet!
+    hcalFB[nHCALTPs] = (hcalTp.SOI_fineGrain() ? 0x1F : 0);
+    expectedTotalET += hcalET[nHCALTPs];
+    nHCALTPs++;
+  }
+  if(nHCALTPs > 0 && 
+     !layer1->setHCALData(&hcalEta[0], &hcalPhi[0], &hcalET[0], &hcalFB[0], nHCALTPs)) {
+    std::cerr << "UCT: Failed loading HCAL towers" << std::endl;
+    return;
   }
   
-  
+  uint64_t inputDone = (metrics != 0 ? UCTMetrics::now() : 0);
+
    //Process
   if(!layer1->process()) {
     std::cerr << "UCT: Failed to process layer 1" << std::endl;
   }
+
+  regionCounters->fill();
+
+  maskedECALET += layer1->getMaskedECALET();
+  maskedHCALET += layer1->getMaskedHCALET();
+
+  if(thresholdScan != 0 && !thresholdScan->scan()) {
+    std::cerr << "UCT: Failed to scan region thresholds" << std::endl;
+  }
   
   
   // Crude check if total ET is approximately OK!
@@ -181,16 +346,22 @@ L1TCaloLayer1::produce(edm::Event& iEvent, const edm::EventSetup& iSetup)
 	      << expectedTotalET << std::dec << std::endl;
   }
 
+  uint64_t processDone = (metrics != 0 ? UCTMetrics::now() : 0);
+
   int theBX = 0; // Currently we only read and process the "hit" BX only
  
-  vector<UCTCrate*> crates = layer1->getCrates();
+  uint32_t saturatedTowers = 0;
+  uint32_t saturatedRegions = 0;
+  const UCTCrateList& crates = layer1->getCrates();
   for(uint32_t crt = 0; crt < crates.size(); crt++) {
-    vector<UCTCard*> cards = crates[crt]->getCards();
+    const UCTCardList& cards = crates[crt]->getCards();
     for(uint32_t crd = 0; crd < cards.size(); crd++) {
-      vector<UCTRegion*> regions = cards[crd]->getRegions();
+      const UCTRegionList& regions = cards[crd]->getRegions();
       for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
-	vector<UCTTower*> towers = regions[rgn]->getTowers();
+	if(regions[rgn]->et() == RegionETMask) saturatedRegions++;
+	const UCTTowerList& towers = regions[rgn]->getTowers();
 	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  if(towers[twr]->et() == etMask) saturatedTowers++;
 	  CaloTower caloTower;
 	  caloTower.setHwPt(towers[twr]->et());               // Bits 0-8 of the 16-bit word per the interface protocol document
 	  caloTower.setHwEtRatio(towers[twr]->er());          // Bits 9-11 of the 16-bit word per the interface protocol document
@@ -207,19 +378,173 @@ L1TCaloLayer1::produce(edm::Event& iEvent, const edm::EventSetup& iSetup)
 
   iEvent.put(towersColl);
 
+  if(packLinks) {
+    linkPacker->pack();
+    std::auto_ptr<std::vector<uint16_t> > linkWords 
+      (new std::vector<uint16_t>(linkPacker->getBuffer(), linkPacker->getBuffer() + linkPacker->size()));
+    iEvent.put(linkWords, "ctp7Links");
+  }
+
+  if(produceGlobalSums) {
+    if(!globalSums->process()) {
+      std::cerr << "UCT: Failed to compute global sums" << std::endl;
+    }
+    putSums(iEvent, globalSums->getTowerSums(), "towerSums");
+    putSums(iEvent, globalSums->getRegionSums(), "regionSums");
+  }
+
+  if(produceSummaryCard) {
+    if(!summaryCard->process()) {
+      std::cerr << "UCT: Failed to process the summary card" << std::endl;
+    }
+    if(verbose) summaryCard->print();
+    putSummaryObjects(iEvent);
+  }
+
+  if(estimatePileup) {
+    pileupEstimator->update();
+    std::auto_ptr<std::vector<float> > regionPileup(new std::vector<float>);
+    for(int regionEta = -MaxUCTRegionsEta / 2; regionEta <= MaxUCTRegionsEta / 2; regionEta++) {
+      if(regionEta != 0) regionPileup->push_back(pileupEstimator->getRegionRingPileup(regionEta));
+    }
+    iEvent.put(regionPileup, "regionRingPileup");
+    std::auto_ptr<std::vector<float> > towerPileup(new std::vector<float>);
+    for(int caloEta = -MaxCaloEta; caloEta <= MaxCaloEta; caloEta++) {
+      towerPileup->push_back(pileupEstimator->getTowerRingPileup(caloEta));
+    }
+    iEvent.put(towerPileup, "towerRingPileup");
+  }
+
+  if(metrics != 0) fillMetrics(start, inputDone, processDone, saturatedTowers, saturatedRegions);
+
+}
+
+void L1TCaloLayer1::defineMetrics(uint32_t interval) {
+  metrics = new UCTMetrics(metricsFile, interval);
+  eventsMetric = metrics->addCounter("uct_emulator_events_total", "Events processed by the Layer-1 emulator");
+  inputTimeMetric = metrics->addCounter("uct_emulator_stage_seconds_total", "Time spent per stage of the emulator module",
+					"stage=\"input\"", 1e-9);
+  processTimeMetric = metrics->addCounter("uct_emulator_stage_seconds_total", "", "stage=\"process\"", 1e-9);
+  outputTimeMetric = metrics->addCounter("uct_emulator_stage_seconds_total", "", "stage=\"output\"", 1e-9);
+  double bounds[] = {1e-4, 2e-4, 5e-4, 1e-3, 2e-3, 5e-3, 1e-2, 2e-2, 5e-2, 1e-1};
+  latencyMetric = metrics->addHistogram("uct_emulator_event_seconds", "Time per event of the emulator module",
+					std::vector<double>(bounds, bounds + sizeof(bounds) / sizeof(double)), 1e-9);
+  saturatedTowersMetric = metrics->addCounter("uct_emulator_saturated_total", "Towers and regions at their maximum ET",
+					      "object=\"tower\"");
+  saturatedRegionsMetric = metrics->addCounter("uct_emulator_saturated_total", "", "object=\"region\"");
+  maskedECALMetric = metrics->addCounter("uct_emulator_masked_et_total", "Input ET of masked channels in compressed TP units",
+					 "calo=\"ecal\"");
+  maskedHCALMetric = metrics->addCounter("uct_emulator_masked_et_total", "", "calo=\"hcal\"");
+  regionsMetric = metrics->addCounter("uct_emulator_regions_total", 
+				      "Central regions with ET, and those that pass the EG and tau vetoes",
+				      "type=\"nonzero\"");
+  egLikeRegionsMetric = metrics->addCounter("uct_emulator_regions_total", "", "type=\"eglike\"");
+  tauLikeRegionsMetric = metrics->addCounter("uct_emulator_regions_total", "", "type=\"taulike\"");
+  if(!metrics->start()) {
+    throw cms::Exception("L1TCaloLayer1") << "Cannot write metrics to " << metricsFile;
+  }
+}
+
+void L1TCaloLayer1::fillMetrics(uint64_t start, uint64_t inputDone, uint64_t processDone,
+				uint32_t saturatedTowers, uint32_t saturatedRegions) {
+  uint64_t done = UCTMetrics::now();
+  metrics->add(eventsMetric);
+  metrics->add(inputTimeMetric, inputDone - start);
+  metrics->add(processTimeMetric, processDone - inputDone);
+  metrics->add(outputTimeMetric, done - processDone);
+  metrics->observe(latencyMetric, done - start);
+  metrics->add(saturatedTowersMetric, saturatedTowers);
+  metrics->add(saturatedRegionsMetric, saturatedRegions);
+  metrics->add(maskedECALMetric, layer1->getMaskedECALET());
+  metrics->add(maskedHCALMetric, layer1->getMaskedHCALET());
+  // Region counts of this event, summed over eta rings and ET bins
+  uint32_t regionCounts[UCTRegionCounters::NCounters] = {0};
+  for(uint32_t c = 0; c < UCTRegionCounters::NCounters; c++) {
+    for(uint32_t ring = 0; ring < NRegionEtaRings; ring++) {
+      for(uint32_t bin = 0; bin < NRegionETBins; bin++) {
+	regionCounts[c] += regionCounters->getEventCount((UCTRegionCounters::Counter) c, ring, bin);
+      }
+    }
+  }
+  metrics->add(regionsMetric, regionCounts[UCTRegionCounters::AllRegions]);
+  metrics->add(egLikeRegionsMetric, regionCounts[UCTRegionCounters::EGLikeRegions]);
+  metrics->add(tauLikeRegionsMetric, regionCounts[UCTRegionCounters::TauLikeRegions]);
+}
+
+void L1TCaloLayer1::putSums(edm::Event& iEvent, const UCTEtSums& sums, const std::string& label) {
+  std::auto_ptr<EtSumBxCollection> sumsColl (new EtSumBxCollection);
+  int theBX = 0;
+  EtSum et;
+  et.setType(EtSum::kTotalEt);
+  et.setHwPt(sums.et);
+  sumsColl->push_back(theBX, et);
+  EtSum ht;
+  ht.setType(EtSum::kTotalHt);
+  ht.setHwPt(sums.ht);
+  sumsColl->push_back(theBX, ht);
+  EtSum met;
+  met.setType(EtSum::kMissingEt);
+  met.setHwPt(sums.met);
+  met.setHwPhi(sums.metPhi);
+  sumsColl->push_back(theBX, met);
+  EtSum mht;
+  mht.setType(EtSum::kMissingHt);
+  mht.setHwPt(sums.mht);
+  mht.setHwPhi(sums.mhtPhi);
+  sumsColl->push_back(theBX, mht);
+  iEvent.put(sumsColl, label);
+}
+
+// Region eta index (-13 to 13, no 0) and region phi index as hardware
+// eta and phi; hardware isolation is 1 for isolated candidates
+
+void L1TCaloLayer1::putSummaryObjects(edm::Event& iEvent) {
+  int theBX = 0;
+  std::auto_ptr<JetBxCollection> jetsColl (new JetBxCollection);
+  const std::vector<UCTSummaryObject>& jets = summaryCard->getJets();
+  for(uint32_t i = 0; i < jets.size(); i++) {
+    Jet jet;
+    jet.setHwPt(jets[i].et);
+    jet.setHwEta(jets[i].index.first);
+    jet.setHwPhi(jets[i].index.second);
+    jetsColl->push_back(theBX, jet);
+  }
+  iEvent.put(jetsColl);
+  std::auto_ptr<EGammaBxCollection> egColl (new EGammaBxCollection);
+  const std::vector<UCTSummaryObject>& egCandidates = summaryCard->getEGCandidates();
+  for(uint32_t i = 0; i < egCandidates.size(); i++) {
+    EGamma eg;
+    eg.setHwPt(egCandidates[i].et);
+    eg.setHwEta(egCandidates[i].index.first);
+    eg.setHwPhi(egCandidates[i].index.second);
+    eg.setHwIso(egCandidates[i].isolated ? 1 : 0);
+    egColl->push_back(theBX, eg);
+  }
+  iEvent.put(egColl);
+  std::auto_ptr<TauBxCollection> tauColl (new TauBxCollection);
+  const std::vector<UCTSummaryObject>& tauCandidates = summaryCard->getTauCandidates();
+  for(uint32_t i = 0; i < tauCandidates.size(); i++) {
+    Tau tau;
+    tau.setHwPt(tauCandidates[i].et);
+    tau.setHwEta(tauCandidates[i].index.first);
+    tau.setHwPhi(tauCandidates[i].index.second);
+    tau.setHwIso(tauCandidates[i].isolated ? 1 : 0);
+    tauColl->push_back(theBX, tau);
+  }
+  iEvent.put(tauColl);
 }
 
 void L1TCaloLayer1::print() {
-  vector<UCTCrate*> crates = layer1->getCrates();
+  const UCTCrateList& crates = layer1->getCrates();
   for(uint32_t crt = 0; crt < crates.size(); crt++) {
-    vector<UCTCard*> cards = crates[crt]->getCards();
+    const UCTCardList& cards = crates[crt]->getCards();
     for(uint32_t crd = 0; crd < cards.size(); crd++) {
-      vector<UCTRegion*> regions = cards[crd]->getRegions();
+      const UCTRegionList& regions = cards[crd]->getRegions();
       for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
 	if(regions[rgn]->et() > 0) {
 	  int hitEta = regions[rgn]->hitCaloEta();
 	  int hitPhi = regions[rgn]->hitCaloPhi();
-	  vector<UCTTower*> towers = regions[rgn]->getTowers();
+	  const UCTTowerList& towers = regions[rgn]->getTowers();
 	  bool header = true;
 	  for(uint32_t twr = 0; twr < towers.size(); twr++) {
 	    if(towers[twr]->caloPhi() == hitPhi && towers[twr]->caloEta() == hitEta) {
@@ -247,23 +572,53 @@ L1TCaloLayer1::beginJob()
 // ------------ method called once each job just after ending the event loop  ------------
 void 
 L1TCaloLayer1::endJob() {
+  if(!channelMaskFile.empty()) {
+    std::cout << "UCT: Masked " << layer1->getNMaskedTowers() << " towers; ECAL ET = " << maskedECALET 
+	      << " HCAL ET = " << maskedHCALET << " (compressed TP units)" << std::endl;
+  }
+  if(verbose) regionCounters->print();
+  if(thresholdScan != 0) thresholdScan->print();
 }
 
 // ------------ method called when starting to processes a run  ------------
-/*
-  void
-  L1TCaloLayer1::beginRun(edm::Run const&, edm::EventSetup const&)
-  {
+void
+L1TCaloLayer1::beginRun(edm::Run const&, edm::EventSetup const&)
+{
+  regionCounters->beginRun();
+  if(pileupEstimator != 0) pileupEstimator->reset();
+
+  // (Re)load the channel masks so that they can change between runs
+  if(!channelMaskFile.empty()) {
+    if(!channelMask.load(channelMaskFile)) {
+      throw cms::Exception("L1TCaloLayer1") << "Failed to load channel masks from " << channelMaskFile;
+    }
+    layer1->setChannelMask(&channelMask);
+    if(verbose) {
+      std::cout << "UCT: Masking " << channelMask.getNMasked() << " towers from " << channelMaskFile << std::endl;
+    }
   }
-*/
+
+  // (Re)load the calibration LUT set so that it can be replaced between runs
+  // The emulator only points into the tables, so it is not rebuilt
+  if(calibrationLUTFile.empty()) return;
+  layer1->setCalibrationLUT(0);
+  if(!calibrationLUT.load(calibrationLUTFile)) {
+    throw cms::Exception("L1TCaloLayer1") << "Failed to load calibration LUTs from " << calibrationLUTFile;
+  }
+  layer1->setCalibrationLUT(&calibrationLUT);
+  if(verbose) {
+    std::cout << "UCT: Using calibration LUT version " << calibrationLUT.getVersion() 
+	      << " from " << calibrationLUTFile << std::endl;
+  }
+}
  
 // ------------ method called when ending the processing of a run  ------------
-/*
-  void
-  L1TCaloLayer1::endRun(edm::Run const&, edm::EventSetup const&)
-  {
-  }
-*/
+void
+L1TCaloLayer1::endRun(edm::Run const&, edm::EventSetup const&)
+{
+  if(verbose) regionCounters->print(true);
+  if(verbose && pileupEstimator != 0) pileupEstimator->print();
+}
  
 // ------------ method called when starting to processes a luminosity block  ------------
 /*
@@ -10,6 +10,9 @@
  Implementation:
               It is expected that we compare CaloTowers from the spy source to that of the emulator.  
               It can be used to compare any two CaloTower collections
+              All crossings present in both collections are compared, and when both hold
+              several crossings their BX alignment is checked through the tower ET correlation
+              between crossings
 */
 //
 // Original Author:  Sridhara Dasu
@@ -20,6 +23,9 @@
 
 // system include files
 #include <memory>
+#include <algorithm>
+#include <map>
+#include <cmath>
 
 // user include files
 #include "FWCore/Framework/interface/Frameworkfwd.h"
@@ -29,10 +35,26 @@
 #include "FWCore/Framework/interface/MakerMacros.h"
 
 #include "FWCore/ParameterSet/interface/ParameterSet.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include "DataFormats/EcalDigi/interface/EcalDigiCollections.h"
+#include "DataFormats/HcalDigi/interface/HcalDigiCollections.h"
 
 #include "DataFormats/L1TCalorimeter/interface/CaloTower.h"
 using namespace l1t;
 
+#include "L1Trigger/L1TCaloLayer1/src/UCTGeometry.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTEventCapture.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTMetrics.hh"
+
+// Towers are labelled by position (caloEta, caloPhi) in a dense index, with
+// one extra position for towers outside the calorimeter indices
+
+#define NBucketEta (2 * MaxCaloEta + 1)
+#define NBucketPhi (MaxCaloPhi + 1)
+#define NTowerPositions (NBucketEta * NBucketPhi)
+#define NTowerBuckets (NSides * NCrates * NCardsInCrate * (NRegionsInCard + NHFRegionsInCard))
+
 //
 // class declaration
 //
@@ -50,6 +72,44 @@ class L1TCaloLayer1Validator : public edm::EDAnalyzer {
       virtual void analyze(const edm::Event&, const edm::EventSetup&) override;
       virtual void endJob() override;
 
+      void checksum(const CaloTowerBxCollection& towers, int theBX, 
+		    std::vector<uint64_t>& sums, std::vector<uint32_t>& counts, std::vector<uint32_t>& nonZeroCounts,
+		    std::vector<uint32_t>& buckets);
+      bool validate(const CaloTowerBxCollection& testTowers, const CaloTowerBxCollection& emulTowers, int theBX);
+      void correlate(const CaloTowerBxCollection& testTowers, const CaloTowerBxCollection& emulTowers);
+
+      // Per crossing counters and mismatch map by tower position
+
+      struct BXCounts {
+	BXCounts() : crossingCount(0), badCrossingCount(0), towerCount(0), badTowerCount(0),
+		     nonZeroTowerCount(0), badNonZeroTowerCount(0), badTowerMap(NTowerPositions + 1, 0) {;}
+	uint32_t crossingCount;
+	uint32_t badCrossingCount;
+	uint32_t towerCount;
+	uint32_t badTowerCount;
+	uint32_t nonZeroTowerCount;
+	uint32_t badNonZeroTowerCount;
+	std::vector<uint32_t> badTowerMap;
+      };
+
+      // Tower ET correlation between the two collections for one crossing
+      // offset (test BX - emul BX), summed over events
+
+      struct BXCorrelation {
+	BXCorrelation() : testEmul(0), testTest(0), emulEmul(0) {;}
+	double get() const {return ((testTest > 0 && emulEmul > 0) ? testEmul / sqrt(testTest * emulEmul) : 0);}
+	double testEmul;
+	double testTest;
+	double emulEmul;
+      };
+
+      bool compare(const CaloTower& testTower, const CaloTower& emulTower, BXCounts& counts);
+
+      void findIncidentalMatches(const CaloTower& testTower, const CaloTowerBxCollection& emulTowers, int theBX);
+
+      void capture(const edm::Event& iEvent, const CaloTowerBxCollection& testTowers, 
+		   const CaloTowerBxCollection& emulTowers, int theBX);
+
       //virtual void beginRun(edm::Run const&, edm::EventSetup const&) override;
       //virtual void endRun(edm::Run const&, edm::EventSetup const&) override;
       //virtual void beginLuminosityBlock(edm::LuminosityBlock const&, edm::EventSetup const&) override;
@@ -64,19 +124,90 @@ class L1TCaloLayer1Validator : public edm::EDAnalyzer {
 
   uint32_t eventCount;
   uint32_t badEventCount;
-  uint32_t towerCount;
-  uint32_t badTowerCount;
-  uint32_t nonZeroTowerCount;
-  uint32_t badNonZeroTowerCount;
+
+  // Every crossing present in both collections is compared; the BX
+  // alignment of the two is checked over all pairs of crossings of events
+  // where both collections hold more than one crossing
+
+  std::map<int, BXCounts> bxCounts;
+  std::map<int, BXCorrelation> bxCorrelations;
+  std::vector<uint32_t> emulETs;
+  std::vector<uint32_t> testPositions;
+  std::vector<uint32_t> testETs;
+  std::vector<uint32_t> testOffsets;
+  std::vector<double> testSquares;
 
   bool verbose;
 
+  // Towers are compared region by region through order independent
+  // checksums; only regions whose checksums differ are compared tower by
+  // tower.  Buckets are the (side, crate, card, region) regions plus one
+  // for towers outside the geometry, which is always compared in full.
+
+  uint32_t nBuckets;
+  std::vector<uint32_t> bucketMap;
+  std::vector<uint64_t> testSums;
+  std::vector<uint64_t> emulSums;
+  std::vector<uint32_t> testCounts;
+  std::vector<uint32_t> testNonZeroCounts;
+  std::vector<uint32_t> emulCounts;
+  std::vector<uint32_t> emulNonZeroCounts;
+  std::vector<uint32_t> testBuckets;
+  std::vector<uint32_t> emulBuckets;
+  std::vector<uint32_t> emulOffsets;
+  std::vector<uint32_t> emulOrder;
+  std::vector<uint32_t> emulNext;
+
+  // Optional capture of mismatching events with their TPs for replay
+  // through the stand-alone emulator (see test/replayUCTCapture.cpp)
+
+  std::string captureFile;
+  bool captureTPs;
+  edm::EDGetTokenT<EcalTrigPrimDigiCollection> ecalTPSource;
+  edm::EDGetTokenT<HcalTrigPrimDigiCollection> hcalTPSource;
+  UCTEventCapture eventCapture;
+  UCTCaptureEvent capturedEvent;
+
+  // Optional Prometheus textfile metrics, see UCTMetrics.hh
+
+  std::string metricsFile;
+  UCTMetrics *metrics;
+  uint32_t eventsMetric;
+  uint32_t badEventsMetric;
+  uint32_t crossingsMetric;
+  uint32_t badCrossingsMetric;
+  uint32_t towersMetric;
+  uint32_t nonZeroTowersMetric;
+  uint32_t badTowersMetric;
+  uint32_t badNonZeroTowersMetric;
+
 };
 
 //
 // constants, enums and typedefs
 //
 
+
+// Tower checksum term: the tower position and its 16-bit compressed data,
+// as in UCTTower::compressedData(), mixed so that the sum over a region
+// does not depend on the order of the towers
+
+static inline uint32_t towerPosition(int caloEta, int caloPhi) {
+  if(caloEta < -MaxCaloEta || caloEta > MaxCaloEta || caloPhi < 0 || caloPhi > MaxCaloPhi) return NTowerPositions;
+  return (caloEta + MaxCaloEta) * NBucketPhi + caloPhi;
+}
+
+static inline uint64_t towerHash(const CaloTower& tower) {
+  uint64_t word = ((uint64_t) (tower.hwEta() & 0xFF) << 24) | ((uint64_t) (tower.hwPhi() & 0xFF) << 16) |
+    ((tower.hwQual() & 0xF) << 12) | ((tower.hwEtRatio() & 0x7) << 9) | (tower.hwPt() & 0x1FF);
+  word ^= word >> 33;
+  word *= 0xff51afd7ed558ccdULL;
+  word ^= word >> 33;
+  word *= 0xc4ceb9fe1a85ec53ULL;
+  word ^= word >> 33;
+  return word;
+}
+
 //
 // static data member definitions
 //
@@ -89,13 +220,64 @@ L1TCaloLayer1Validator::L1TCaloLayer1Validator(const edm::ParameterSet& iConfig)
   emulSource(consumes<CaloTowerBxCollection>(iConfig.getParameter<edm::InputTag>("emulSource"))),
   eventCount(0),
   badEventCount(0),
-  towerCount(0),
-  badTowerCount(0),
-  nonZeroTowerCount(0),
-  badNonZeroTowerCount(0),
-  verbose(iConfig.getParameter<bool>("verbose")) {}
+  emulETs(NTowerPositions + 1, 0),
+  verbose(iConfig.getParameter<bool>("verbose")),
+  nBuckets(NTowerBuckets + 1),
+  bucketMap(NTowerPositions + 1, NTowerBuckets),
+  testSums(nBuckets),
+  emulSums(nBuckets),
+  testCounts(nBuckets),
+  testNonZeroCounts(nBuckets),
+  emulCounts(nBuckets),
+  emulNonZeroCounts(nBuckets),
+  emulOffsets(nBuckets + 1),
+  captureFile(iConfig.getParameter<std::string>("captureFile")),
+  captureTPs(false),
+  metricsFile(iConfig.getParameter<std::string>("metricsFile")),
+  metrics(0) {
+  // TPs are captured when their sources are given, normally those of the
+  // emulator that made emulSource
+  edm::InputTag ecalTPTag = iConfig.getParameter<edm::InputTag>("ecalTPSource");
+  edm::InputTag hcalTPTag = iConfig.getParameter<edm::InputTag>("hcalTPSource");
+  if(!captureFile.empty() && !ecalTPTag.label().empty() && !hcalTPTag.label().empty()) {
+    ecalTPSource = consumes<EcalTrigPrimDigiCollection>(ecalTPTag);
+    hcalTPSource = consumes<HcalTrigPrimDigiCollection>(hcalTPTag);
+    captureTPs = true;
+  }
+  // Region bucket of every (caloEta, caloPhi)
+  UCTGeometry g;
+  for(int caloEta = -MaxCaloEta; caloEta <= MaxCaloEta; caloEta++) {
+    if(caloEta == 0) continue;
+    for(int caloPhi = 1; caloPhi <= MaxCaloPhi; caloPhi++) {
+      uint32_t crate = g.getCrate(caloEta, caloPhi);
+      uint32_t card = g.getCard(caloEta, caloPhi);
+      uint32_t region = g.getRegion(caloEta, caloPhi);
+      if(g.checkCrate(crate) || g.checkCard(card) || g.checkRegion(region)) continue;
+      uint32_t side = (caloEta < 0) ? 0 : 1;
+      bucketMap[towerPosition(caloEta, caloPhi)] =
+	((side * NCrates + crate) * NCardsInCrate + card) * (NRegionsInCard + NHFRegionsInCard) + region;
+    }
+  }
+  if(!metricsFile.empty()) {
+    metrics = new UCTMetrics(metricsFile, iConfig.getParameter<unsigned int>("metricsInterval"));
+    eventsMetric = metrics->addCounter("uct_validator_events_total", "Events compared by the Layer-1 validator");
+    badEventsMetric = metrics->addCounter("uct_validator_bad_events_total", "Events with any tower mismatch");
+    crossingsMetric = metrics->addCounter("uct_validator_crossings_total", "Crossings compared");
+    badCrossingsMetric = metrics->addCounter("uct_validator_bad_crossings_total", "Crossings with any tower mismatch");
+    towersMetric = metrics->addCounter("uct_validator_towers_total", "Towers compared", "et=\"any\"");
+    nonZeroTowersMetric = metrics->addCounter("uct_validator_towers_total", "", "et=\"nonzero\"");
+    badTowersMetric = metrics->addCounter("uct_validator_bad_towers_total", "Towers that do not match",
+					  "et=\"any\"");
+    badNonZeroTowersMetric = metrics->addCounter("uct_validator_bad_towers_total", "", "et=\"nonzero\"");
+    if(!metrics->start()) {
+      throw cms::Exception("L1TCaloLayer1Validator") << "Cannot write metrics to " << metricsFile;
+    }
+  }
+}
 
-L1TCaloLayer1Validator::~L1TCaloLayer1Validator() {}
+L1TCaloLayer1Validator::~L1TCaloLayer1Validator() {
+  if(metrics != 0) delete metrics;
+}
 
 //
 // member functions
@@ -106,86 +288,374 @@ void
 L1TCaloLayer1Validator::analyze(const edm::Event& iEvent, const edm::EventSetup& iSetup)
 {
    using namespace edm;
-   bool badEvent = false;
    edm::Handle<CaloTowerBxCollection> testTowers;
    iEvent.getByToken(testSource, testTowers);
    edm::Handle<CaloTowerBxCollection> emulTowers;
    iEvent.getByToken(emulSource, emulTowers);
-   int theBX = 0;
-   for(std::vector<CaloTower>::const_iterator testTower = testTowers->begin(theBX);
-       testTower != testTowers->end(theBX);
-       ++testTower) {
-     for(std::vector<CaloTower>::const_iterator emulTower = emulTowers->begin(theBX);
-	 emulTower != emulTowers->end(theBX);
-	 ++emulTower) {
-       int test_iEta = testTower->hwEta();
-       int test_iPhi = testTower->hwPhi();
-       int test_et = testTower->hwPt();
-       int test_er = testTower->hwEtRatio();
-       int test_fb = testTower->hwQual();
-       int emul_iEta = emulTower->hwEta();
-       int emul_iPhi = emulTower->hwPhi();
-       int emul_et = emulTower->hwPt();
-       int emul_er = emulTower->hwEtRatio();
-       int emul_fb = emulTower->hwQual();
-       bool success = true;
-       if(test_iEta == emul_iEta && test_iPhi == emul_iPhi) {
-	 if(test_et != emul_et) {success = false;}
-	 if(test_er != emul_er) {success = false;}
-	 if(test_fb != emul_fb) {success = false;}
-	 if(!success) {
-	   if(test_et != emul_et) {if(verbose) std::cout << "ET ";}
-	   if(test_er != emul_er) {if(verbose) std::cout << "ER ";}
-	   if(test_fb != emul_fb) {if(verbose) std::cout << "FB ";}
-	   if(verbose) std::cout << "Checks failed for ("
-				 << test_iEta << ", "
-				 << test_iPhi << ") : ("
-				 << test_et << ", "
-				 << test_er << ", "
-				 << test_fb << ") != ("
-				 << emul_et << ", "
-				 << emul_er << ", "
-				 << emul_fb << ")" << std::endl;
-	   badEvent = true;
-	   badTowerCount++;
-	   if(test_et > 0) badNonZeroTowerCount++;
-	 }
-	 towerCount++;
-	 if(test_et > 0) nonZeroTowerCount++;
+   int firstBX = std::max(testTowers->getFirstBX(), emulTowers->getFirstBX());
+   int lastBX = std::min(testTowers->getLastBX(), emulTowers->getLastBX());
+   int badBX = lastBX + 1;
+   for(int theBX = firstBX; theBX <= lastBX; theBX++) {
+     if(!validate(*testTowers, *emulTowers, theBX) && badBX > lastBX) badBX = theBX;
+   }
+   // The correlation looks at every pair of crossings, so it is left out
+   // when either collection holds only one, as in normal running
+   if(testTowers->getLastBX() > testTowers->getFirstBX() && emulTowers->getLastBX() > emulTowers->getFirstBX()) {
+     correlate(*testTowers, *emulTowers);
+   }
+   if(badBX <= lastBX) {
+     badEventCount++;
+     // A capture record holds one crossing, the first bad one, and the TPs
+     // only when that is the triggered crossing
+     if(!captureFile.empty()) capture(iEvent, *testTowers, *emulTowers, badBX);
+   }
+   eventCount++;
+   if(metrics != 0) {
+     metrics->add(eventsMetric);
+     if(badBX <= lastBX) metrics->add(badEventsMetric);
+   }
+}
+
+// Compares one crossing; returns false for a mismatch
+
+bool
+L1TCaloLayer1Validator::validate(const CaloTowerBxCollection& testTowers, const CaloTowerBxCollection& emulTowers, 
+				 int theBX)
+{
+   BXCounts& counts = bxCounts[theBX];
+   uint32_t towers = counts.towerCount;
+   uint32_t nonZeroTowers = counts.nonZeroTowerCount;
+   uint32_t badTowers = counts.badTowerCount;
+   uint32_t badNonZeroTowers = counts.badNonZeroTowerCount;
+   bool badCrossing = false;
+   checksum(testTowers, theBX, testSums, testCounts, testNonZeroCounts, testBuckets);
+   checksum(emulTowers, theBX, emulSums, emulCounts, emulNonZeroCounts, emulBuckets);
+   bool checksumsMatch = true;
+   for(uint32_t b = 0; b < NTowerBuckets; b++) {
+     if(testSums[b] != emulSums[b] || testCounts[b] != emulCounts[b]) checksumsMatch = false;
+   }
+   if(testCounts[NTowerBuckets] != 0 || emulCounts[NTowerBuckets] != 0) checksumsMatch = false;
+   if(checksumsMatch) {
+     // Common case: all regions agree
+     for(uint32_t b = 0; b < nBuckets; b++) {
+       counts.towerCount += testCounts[b];
+       counts.nonZeroTowerCount += testNonZeroCounts[b];
+     }
+   }
+   else {
+     // Emulator towers grouped by bucket
+     for(uint32_t b = 0; b < nBuckets; b++) emulOffsets[b + 1] = emulOffsets[b] + emulCounts[b];
+     emulOrder.resize(emulBuckets.size());
+     emulNext.assign(emulOffsets.begin(), emulOffsets.end() - 1);
+     for(uint32_t i = 0; i < emulBuckets.size(); i++) emulOrder[emulNext[emulBuckets[i]]++] = i;
+     for(uint32_t i = 0; i < testBuckets.size(); i++) {
+       uint32_t b = testBuckets[i];
+       if(b != NTowerBuckets && testSums[b] == emulSums[b] && testCounts[b] == emulCounts[b]) {
+	 counts.towerCount++;
+	 if(testTowers.at(theBX, i).hwPt() > 0) counts.nonZeroTowerCount++;
+	 continue;
+       }
+       const CaloTower& testTower = testTowers.at(theBX, i);
+       bool badTower = false;
+       for(uint32_t j = emulOffsets[b]; j < emulOffsets[b + 1]; j++) {
+	 if(!compare(testTower, emulTowers.at(theBX, emulOrder[j]), counts)) badTower = true;
        }
-       if(!success && test_et == emul_et && test_iPhi == emul_iPhi && test_et > 3) {
-	   if(verbose) std::cout << "Incidental match for ("
-				 << test_iEta << ", "
-				 << test_iPhi << ") : ("
-				 << test_et << ", "
-				 << test_er << ", "
-				 << test_fb << ") != ("
-				 << emul_iEta <<","
-				 << emul_iPhi<<") :("
-				 << emul_et << ", "
-				 << emul_er << ", "
-				 << emul_fb << ")" << std::endl;
+       if(badTower) {
+	 badCrossing = true;
+	 if(verbose) findIncidentalMatches(testTower, emulTowers, theBX);
        }
      }
    }
-   if(badEvent) badEventCount++;
-   eventCount++;
+   counts.crossingCount++;
+   if(badCrossing) counts.badCrossingCount++;
+   if(metrics != 0) {
+     metrics->add(crossingsMetric);
+     if(badCrossing) metrics->add(badCrossingsMetric);
+     metrics->add(towersMetric, counts.towerCount - towers);
+     metrics->add(nonZeroTowersMetric, counts.nonZeroTowerCount - nonZeroTowers);
+     metrics->add(badTowersMetric, counts.badTowerCount - badTowers);
+     metrics->add(badNonZeroTowersMetric, counts.badNonZeroTowerCount - badNonZeroTowers);
+   }
+   return !badCrossing;
+}
+
+// Accumulates the tower ET correlation for every pair of test and emulator
+// crossings, by crossing offset
+
+void
+L1TCaloLayer1Validator::correlate(const CaloTowerBxCollection& testTowers, const CaloTowerBxCollection& emulTowers)
+{
+  // Non-zero test towers of each crossing
+  testPositions.clear();
+  testETs.clear();
+  testOffsets.assign(1, 0);
+  testSquares.clear();
+  for(int testBX = testTowers.getFirstBX(); testBX <= testTowers.getLastBX(); testBX++) {
+    double squares = 0;
+    for(std::vector<CaloTower>::const_iterator tower = testTowers.begin(testBX);
+	tower != testTowers.end(testBX);
+	++tower) {
+      uint32_t position = towerPosition(tower->hwEta(), tower->hwPhi());
+      if(tower->hwPt() <= 0 || position == NTowerPositions) continue;
+      testPositions.push_back(position);
+      testETs.push_back(tower->hwPt());
+      squares += (double) tower->hwPt() * tower->hwPt();
+    }
+    testOffsets.push_back(testPositions.size());
+    testSquares.push_back(squares);
+  }
+  // Emulator ETs are laid out by position one crossing at a time
+  for(int emulBX = emulTowers.getFirstBX(); emulBX <= emulTowers.getLastBX(); emulBX++) {
+    double squares = 0;
+    for(std::vector<CaloTower>::const_iterator tower = emulTowers.begin(emulBX);
+	tower != emulTowers.end(emulBX);
+	++tower) {
+      if(tower->hwPt() <= 0) continue;
+      emulETs[towerPosition(tower->hwEta(), tower->hwPhi())] = tower->hwPt();
+      squares += (double) tower->hwPt() * tower->hwPt();
+    }
+    for(uint32_t t = 0; t < testSquares.size(); t++) {
+      double testEmul = 0;
+      for(uint32_t i = testOffsets[t]; i < testOffsets[t + 1]; i++) {
+	testEmul += (double) testETs[i] * emulETs[testPositions[i]];
+      }
+      BXCorrelation& correlation = bxCorrelations[testTowers.getFirstBX() + (int) t - emulBX];
+      correlation.testEmul += testEmul;
+      correlation.testTest += testSquares[t];
+      correlation.emulEmul += squares;
+    }
+    for(std::vector<CaloTower>::const_iterator tower = emulTowers.begin(emulBX);
+	tower != emulTowers.end(emulBX);
+	++tower) {
+      emulETs[towerPosition(tower->hwEta(), tower->hwPhi())] = 0;
+    }
+  }
+}
+
+void
+L1TCaloLayer1Validator::checksum(const CaloTowerBxCollection& towers, int theBX, 
+				 std::vector<uint64_t>& sums, std::vector<uint32_t>& counts, std::vector<uint32_t>& nonZeroCounts,
+				 std::vector<uint32_t>& buckets)
+{
+  std::fill(sums.begin(), sums.end(), 0);
+  std::fill(counts.begin(), counts.end(), 0);
+  std::fill(nonZeroCounts.begin(), nonZeroCounts.end(), 0);
+  buckets.resize(towers.size(theBX));
+  uint32_t i = 0;
+  for(std::vector<CaloTower>::const_iterator tower = towers.begin(theBX);
+      tower != towers.end(theBX);
+      ++tower, ++i) {
+    int caloEta = tower->hwEta();
+    int caloPhi = tower->hwPhi();
+    uint32_t b = NTowerBuckets;
+    if(caloEta >= -MaxCaloEta && caloEta <= MaxCaloEta && caloPhi >= 0 && caloPhi <= MaxCaloPhi)
+      b = bucketMap[(caloEta + MaxCaloEta) * NBucketPhi + caloPhi];
+    buckets[i] = b;
+    sums[b] += towerHash(*tower);
+    counts[b]++;
+    if(tower->hwPt() > 0) nonZeroCounts[b]++;
+  }
+}
+
+// Compares towers at the same position; returns false for a mismatch
+
+bool
+L1TCaloLayer1Validator::compare(const CaloTower& testTower, const CaloTower& emulTower, BXCounts& counts)
+{
+  int test_iEta = testTower.hwEta();
+  int test_iPhi = testTower.hwPhi();
+  int test_et = testTower.hwPt();
+  int test_er = testTower.hwEtRatio();
+  int test_fb = testTower.hwQual();
+  int emul_iEta = emulTower.hwEta();
+  int emul_iPhi = emulTower.hwPhi();
+  int emul_et = emulTower.hwPt();
+  int emul_er = emulTower.hwEtRatio();
+  int emul_fb = emulTower.hwQual();
+  bool success = true;
+  if(test_iEta == emul_iEta && test_iPhi == emul_iPhi) {
+    if(test_et != emul_et) {success = false;}
+    if(test_er != emul_er) {success = false;}
+    if(test_fb != emul_fb) {success = false;}
+    if(!success) {
+      if(test_et != emul_et) {if(verbose) std::cout << "ET ";}
+      if(test_er != emul_er) {if(verbose) std::cout << "ER ";}
+      if(test_fb != emul_fb) {if(verbose) std::cout << "FB ";}
+      if(verbose) std::cout << "Checks failed for ("
+			    << test_iEta << ", "
+			    << test_iPhi << ") : ("
+			    << test_et << ", "
+			    << test_er << ", "
+			    << test_fb << ") != ("
+			    << emul_et << ", "
+			    << emul_er << ", "
+			    << emul_fb << ")" << std::endl;
+      counts.badTowerCount++;
+      if(test_et > 0) counts.badNonZeroTowerCount++;
+      counts.badTowerMap[towerPosition(test_iEta, test_iPhi)]++;
+    }
+    counts.towerCount++;
+    if(test_et > 0) counts.nonZeroTowerCount++;
+  }
+  if(!success && test_et == emul_et && test_iPhi == emul_iPhi && test_et > 3) {
+    if(verbose) std::cout << "Incidental match for ("
+			  << test_iEta << ", "
+			  << test_iPhi << ") : ("
+			  << test_et << ", "
+			  << test_er << ", "
+			  << test_fb << ") != ("
+			  << emul_iEta <<","
+			  << emul_iPhi<<") :("
+			  << emul_et << ", "
+			  << emul_er << ", "
+			  << emul_fb << ")" << std::endl;
+  }
+  return success;
+}
+
+// Verbose diagnostic for a bad tower: scans all emulator towers, in every
+// region, for one at another eta with the same phi and ET, as left by an
+// eta shift
+
+void
+L1TCaloLayer1Validator::findIncidentalMatches(const CaloTower& testTower, const CaloTowerBxCollection& emulTowers,
+					      int theBX)
+{
+  int test_iEta = testTower.hwEta();
+  int test_iPhi = testTower.hwPhi();
+  int test_et = testTower.hwPt();
+  if(test_et <= 3) return;
+  for(std::vector<CaloTower>::const_iterator emulTower = emulTowers.begin(theBX);
+      emulTower != emulTowers.end(theBX);
+      ++emulTower) {
+    // The tower at the same position is reported by compare()
+    if(emulTower->hwEta() == test_iEta || emulTower->hwPhi() != test_iPhi || emulTower->hwPt() != test_et) continue;
+    std::cout << "Incidental match for ("
+	      << test_iEta << ", "
+	      << test_iPhi << ") : ("
+	      << test_et << ", "
+	      << testTower.hwEtRatio() << ", "
+	      << testTower.hwQual() << ") != ("
+	      << emulTower->hwEta() <<","
+	      << emulTower->hwPhi()<<") :("
+	      << emulTower->hwPt() << ", "
+	      << emulTower->hwEtRatio() << ", "
+	      << emulTower->hwQual() << ")" << std::endl;
+  }
+}
+
+void
+L1TCaloLayer1Validator::capture(const edm::Event& iEvent, const CaloTowerBxCollection& testTowers, 
+				const CaloTowerBxCollection& emulTowers, int theBX)
+{
+  capturedEvent.clear();
+  capturedEvent.run = iEvent.id().run();
+  capturedEvent.lumi = iEvent.id().luminosityBlock();
+  capturedEvent.event = iEvent.id().event();
+  capturedEvent.bx = theBX;
+  if(captureTPs && theBX == 0) {
+    // TPs as they are given to the emulator by L1TCaloLayer1::produce()
+    edm::Handle<EcalTrigPrimDigiCollection> ecalTPs;
+    iEvent.getByToken(ecalTPSource, ecalTPs);
+    edm::Handle<HcalTrigPrimDigiCollection> hcalTPs;
+    iEvent.getByToken(hcalTPSource, hcalTPs);
+    for ( const auto& ecalTp : *ecalTPs ) {
+      if(ecalTp.compressedEt() == 0) continue;
+      capturedEvent.ecalTPs.push_back(UCTCaptureEvent::packTP(ecalTp.id().ieta(), ecalTp.id().iphi(),
+							      ecalTp.compressedEt(), ecalTp.fineGrain()));
+    }
+    for ( const auto& hcalTp : *hcalTPs ) {
+      if(hcalTp.SOI_compressedEt() == 0) continue;
+      capturedEvent.hcalTPs.push_back(UCTCaptureEvent::packTP(hcalTp.id().ieta(), hcalTp.id().iphi(),
+							      hcalTp.SOI_compressedEt(), (hcalTp.SOI_fineGrain() ? 0x1F : 0)));
+    }
+  }
+  const CaloTowerBxCollection* collections[2] = {&testTowers, &emulTowers};
+  std::vector<uint32_t>* words[2] = {&capturedEvent.testTowers, &capturedEvent.emulTowers};
+  for(uint32_t c = 0; c < 2; c++) {
+    for(std::vector<CaloTower>::const_iterator tower = collections[c]->begin(theBX);
+	tower != collections[c]->end(theBX);
+	++tower) {
+      uint32_t word = UCTCaptureEvent::packTower(tower->hwEta(), tower->hwPhi(), tower->hwPt(), 
+						 tower->hwEtRatio(), tower->hwQual());
+      if(!UCTCaptureEvent::isEmptyTower(word)) words[c]->push_back(word);
+    }
+  }
+  if(!eventCapture.write(capturedEvent)) {
+    std::cerr << "L1TCaloLayer1Validator: Failed to capture event " << capturedEvent.event 
+	      << " -- capture disabled" << std::endl;
+    captureFile.clear();
+  }
 }
 
 // ------------ method called once each job just before starting event loop  ------------
 void 
 L1TCaloLayer1Validator::beginJob()
 {
+  if(!captureFile.empty() && !eventCapture.openForWrite(captureFile)) {
+    throw cms::Exception("L1TCaloLayer1Validator") << "Cannot capture to " << captureFile;
+  }
 }
 
 // ------------ method called once each job just after ending the event loop  ------------
 void 
 L1TCaloLayer1Validator::endJob() 
 {
+  BXCounts total;
+  for(std::map<int, BXCounts>::const_iterator c = bxCounts.begin(); c != bxCounts.end(); ++c) {
+    total.towerCount += c->second.towerCount;
+    total.badTowerCount += c->second.badTowerCount;
+    total.nonZeroTowerCount += c->second.nonZeroTowerCount;
+    total.badNonZeroTowerCount += c->second.badNonZeroTowerCount;
+  }
   std::cout << "L1TCaloLayer1Vaidator: Summary is Non-Zero Bad Tower / Bad Tower / Event Count = ("
-	    << badNonZeroTowerCount << " of " << nonZeroTowerCount << ") / ("
-	    << badTowerCount << " of " << towerCount << ") / ("
+	    << total.badNonZeroTowerCount << " of " << total.nonZeroTowerCount << ") / ("
+	    << total.badTowerCount << " of " << total.towerCount << ") / ("
 	    << badEventCount << " of " << eventCount << ")" << std::endl;
+  for(std::map<int, BXCounts>::const_iterator c = bxCounts.begin(); c != bxCounts.end(); ++c) {
+    const BXCounts& counts = c->second;
+    std::cout << "L1TCaloLayer1Validator: BX " << c->first 
+	      << " Non-Zero Bad Tower / Bad Tower / Crossing Count = ("
+	      << counts.badNonZeroTowerCount << " of " << counts.nonZeroTowerCount << ") / ("
+	      << counts.badTowerCount << " of " << counts.towerCount << ") / ("
+	      << counts.badCrossingCount << " of " << counts.crossingCount << ")" << std::endl;
+    // Mismatch map, most frequently bad towers first; the ten worst unless verbose
+    std::vector<std::pair<uint32_t, uint32_t> > badTowers;
+    for(uint32_t position = 0; position < NTowerPositions; position++) {
+      if(counts.badTowerMap[position] != 0) badTowers.push_back(std::make_pair(counts.badTowerMap[position], position));
+    }
+    std::sort(badTowers.rbegin(), badTowers.rend());
+    if(!verbose && badTowers.size() > 10) badTowers.resize(10);
+    for(uint32_t i = 0; i < badTowers.size(); i++) {
+      std::cout << "L1TCaloLayer1Validator:   BX " << c->first << " tower ("
+		<< ((int) (badTowers[i].second / NBucketPhi) - MaxCaloEta) << ", "
+		<< (badTowers[i].second % NBucketPhi) << ") bad in " << badTowers[i].first << " crossings" << std::endl;
+    }
+    if(counts.badTowerMap[NTowerPositions] != 0) {
+      std::cout << "L1TCaloLayer1Validator:   BX " << c->first << " towers outside the calorimeter indices bad "
+		<< counts.badTowerMap[NTowerPositions] << " times" << std::endl;
+    }
+  }
+  // BX alignment: the crossing offset with the best tower ET correlation,
+  // which should be zero
+  std::map<int, BXCorrelation>::const_iterator best = bxCorrelations.end();
+  for(std::map<int, BXCorrelation>::const_iterator c = bxCorrelations.begin(); c != bxCorrelations.end(); ++c) {
+    if(verbose) std::cout << "L1TCaloLayer1Validator: Test - emul BX offset " << c->first 
+			  << " tower ET correlation " << c->second.get() << std::endl;
+    if(c->second.get() > 0 && (best == bxCorrelations.end() || c->second.get() > best->second.get())) best = c;
+  }
+  if(best != bxCorrelations.end()) {
+    std::cout << "L1TCaloLayer1Validator: Best tower ET correlation " << best->second.get() 
+	      << " at test - emul BX offset " << best->first;
+    if(best->first != 0) std::cout << " -- collections are misaligned (correlation at offset 0 is "
+				   << bxCorrelations[0].get() << ")";
+    std::cout << std::endl;
+  }
+  if(!captureFile.empty()) {
+    std::cout << "L1TCaloLayer1Vaidator: Captured " << eventCapture.getNEvents() << " events to " << captureFile
+	      << (captureTPs ? "" : " without TPs") << std::endl;
+    eventCapture.close();
+  }
 }
 
 // ------------ method called when starting to processes a run  ------------
@@ -3,5 +3,26 @@ import FWCore.ParameterSet.Config as cms
 layer1EmulatorDigis = cms.EDProducer('L1TCaloLayer1',
                                      ecalTPSource = cms.InputTag("l1tCaloLayer1Digis"),
                                      hcalTPSource = cms.InputTag("l1tCaloLayer1Digis"),
-                                     verbose = cms.bool(False)
+                                     verbose = cms.bool(False),
+                                     packLinks = cms.bool(False),
+                                     calibrationLUTFile = cms.string(""),
+                                     # Lines of "caloEta caloPhi ecalMasked hcalMasked"
+                                     channelMaskFile = cms.string(""),
+                                     produceGlobalSums = cms.bool(False),
+                                     towerHTThreshold = cms.uint32(0),
+                                     regionHTThreshold = cms.uint32(0),
+                                     # Jet, EG and tau candidates of the summary card, see src/UCTSummaryCard.hh
+                                     produceSummaryCard = cms.bool(False),
+                                     summaryJetSeed = cms.uint32(10),
+                                     summaryEGSeed = cms.uint32(5),
+                                     summaryTauSeed = cms.uint32(5),
+                                     summaryIsolationFraction = cms.double(0.25),
+                                     estimatePileup = cms.bool(False),
+                                     # Running average weight is 1/2^pileupAverageShift
+                                     pileupAverageShift = cms.uint32(5),
+                                     # Each PSet holds activityFraction, ecalActivityFraction and miscActivityFraction
+                                     regionThresholdScan = cms.VPSet(),
+                                     # Prometheus textfile metrics, rewritten every metricsInterval seconds
+                                     metricsFile = cms.string(""),
+                                     metricsInterval = cms.uint32(30)
                                      )
@@ -3,5 +3,13 @@ import FWCore.ParameterSet.Config as cms
 layer1Validator = cms.EDAnalyzer('L1TCaloLayer1Validator',
                                  testSource = cms.InputTag("l1tCaloLayer1SpyDigis"),
                                  emulSource = cms.InputTag("layer1EmulatorDigis"),
-                                 verbose = cms.bool(False)
+                                 verbose = cms.bool(False),
+                                 # Binary capture of mismatching events for test/replayUCTCapture
+                                 # TPs are included when both TP sources are given
+                                 captureFile = cms.string(""),
+                                 ecalTPSource = cms.InputTag(""),
+                                 hcalTPSource = cms.InputTag(""),
+                                 # Prometheus textfile metrics, rewritten every metricsInterval seconds
+                                 metricsFile = cms.string(""),
+                                 metricsInterval = cms.uint32(30)
                                  )
@@ -0,0 +1,136 @@
+"""Batch emulation of Layer-1 from Python
+
+Thin ctypes wrapper around the C interface in src/UCTCInterface.hh.  The
+whole batch is processed by one call into the emulator library, during
+which ctypes releases the GIL.  Input arrays that already have the right
+dtype and layout are passed in place, and outputs are written directly
+into NumPy arrays, which can be preallocated and reused between batches.
+
+  from L1Trigger.L1TCaloLayer1.uctEmulator import UCTEmulator
+  emu = UCTEmulator()
+  towers, regions, summaries = emu.process(ecal, hcal)
+
+ecal and hcal are (offsets, caloEta, caloPhi, et, flag) tuples of arrays
+for a batch of events: the TPs of event e are offsets[e]:offsets[e + 1].
+towers[e, i] and regions[e, i] are the packed tower and region words,
+labelled by towerCaloEta/towerCaloPhi and regionEta/regionPhi.
+"""
+
+import ctypes
+import numpy as np
+
+towerETMask = 0x1FF
+regionETMask = 0x3FF
+
+def _array(dtype):
+    return np.ctypeslib.ndpointer(dtype=dtype, ndim=1, flags='C_CONTIGUOUS')
+
+def _optionalArray(dtype):
+    # Output arrays may be None
+    base = np.ctypeslib.ndpointer(dtype=dtype, flags='C_CONTIGUOUS')
+    class OptionalArray(base):
+        @classmethod
+        def from_param(cls, obj):
+            if obj is None:
+                return None
+            return base.from_param(obj)
+    return OptionalArray
+
+class UCTEmulator(object):
+
+    def __init__(self, library='libL1TriggerL1TCaloLayer1.so'):
+        lib = ctypes.CDLL(library)
+        handle = ctypes.c_void_p
+        lib.uctCreate.restype = handle
+        lib.uctCreate.argtypes = []
+        lib.uctDestroy.restype = None
+        lib.uctDestroy.argtypes = [handle]
+        lib.uctGetNTowers.restype = ctypes.c_uint32
+        lib.uctGetNTowers.argtypes = [handle]
+        lib.uctGetNRegions.restype = ctypes.c_uint32
+        lib.uctGetNRegions.argtypes = [handle]
+        lib.uctGetTowerIndices.restype = ctypes.c_bool
+        lib.uctGetTowerIndices.argtypes = [handle, _array(np.int32), _array(np.int32)]
+        lib.uctGetRegionIndices.restype = ctypes.c_bool
+        lib.uctGetRegionIndices.argtypes = [handle, _array(np.int32), _array(np.int32)]
+        tps = [_array(np.uint32), ctypes.c_uint32,
+               _array(np.int32), _array(np.int32), _array(np.uint32), _array(np.uint32)]
+        lib.uctProcessBatch.restype = ctypes.c_bool
+        lib.uctProcessBatch.argtypes = ([handle, ctypes.c_uint32] + tps + tps +
+                                        [_optionalArray(np.uint32)] * 3)
+        self.lib = lib
+        self.uct = lib.uctCreate()
+        self.nTowers = lib.uctGetNTowers(self.uct)
+        self.nRegions = lib.uctGetNRegions(self.uct)
+        self.towerCaloEta = np.zeros(self.nTowers, dtype=np.int32)
+        self.towerCaloPhi = np.zeros(self.nTowers, dtype=np.int32)
+        lib.uctGetTowerIndices(self.uct, self.towerCaloEta, self.towerCaloPhi)
+        self.regionEta = np.zeros(self.nRegions, dtype=np.int32)
+        self.regionPhi = np.zeros(self.nRegions, dtype=np.int32)
+        lib.uctGetRegionIndices(self.uct, self.regionEta, self.regionPhi)
+
+    def close(self):
+        if self.uct is not None:
+            self.lib.uctDestroy(self.uct)
+            self.uct = None
+
+    def __del__(self):
+        self.close()
+
+    def allocate(self, nEvents):
+        """Output arrays for a batch of nEvents events"""
+        return (np.zeros((nEvents, self.nTowers), dtype=np.uint32),
+                np.zeros((nEvents, self.nRegions), dtype=np.uint32),
+                np.zeros(nEvents, dtype=np.uint32))
+
+    def process(self, ecal, hcal, out=None, towers=True, regions=True):
+        """Process a batch; returns (towers, regions, summaries)
+
+        out may be a tuple from allocate() of at least the batch size to be
+        filled in place; towers or regions may be turned off to skip them.
+        The emulator library does no bounds checks beyond the TP offsets, so
+        all shapes are checked here before the call.
+        """
+        ecal = self._tps(ecal, 'ECAL')
+        hcal = self._tps(hcal, 'HCAL')
+        nEvents = len(ecal[0]) - 1
+        if len(hcal[0]) - 1 != nEvents:
+            raise ValueError('ECAL and HCAL batches have different numbers of events')
+        if out is None:
+            out = self.allocate(nEvents)
+        towerData, regionData, summaries = out
+        self._checkOutput(towerData, self.nTowers, nEvents, 'Tower')
+        self._checkOutput(regionData, self.nRegions, nEvents, 'Region')
+        if summaries.ndim != 1 or len(summaries) < nEvents:
+            raise ValueError('Summary array must be 1-D with at least %d entries' % nEvents)
+        towerData = towerData[:nEvents] if towers else None
+        regionData = regionData[:nEvents] if regions else None
+        args = ecal[:1] + (len(ecal[1]),) + ecal[1:] + hcal[:1] + (len(hcal[1]),) + hcal[1:]
+        if not self.lib.uctProcessBatch(self.uct, nEvents, *(args + (towerData, regionData, summaries))):
+            raise RuntimeError('Layer-1 emulation of the batch failed')
+        return towerData, regionData, summaries[:nEvents]
+
+    @staticmethod
+    def _tps(tps, name):
+        offsets, caloEta, caloPhi, et, flag = tps
+        tps = (np.ascontiguousarray(offsets, dtype=np.uint32),
+               np.ascontiguousarray(caloEta, dtype=np.int32),
+               np.ascontiguousarray(caloPhi, dtype=np.int32),
+               np.ascontiguousarray(et, dtype=np.uint32),
+               np.ascontiguousarray(flag, dtype=np.uint32))
+        offsets = tps[0]
+        if any(a.ndim != 1 for a in tps) or len(offsets) < 1:
+            raise ValueError('%s TP arrays must be 1-D, with at least one offset' % name)
+        nTPs = len(tps[1])
+        if any(len(a) != nTPs for a in tps[2:]):
+            raise ValueError('%s TP arrays have different lengths' % name)
+        if np.any(offsets[1:] < offsets[:-1]):
+            raise ValueError('%s TP offsets must not decrease' % name)
+        if offsets[-1] > nTPs:
+            raise ValueError('%s TP offsets run past the %d TPs' % (name, nTPs))
+        return tps
+
+    @staticmethod
+    def _checkOutput(data, nObjects, nEvents, name):
+        if data.ndim != 2 or data.shape[1] != nObjects or data.shape[0] < nEvents:
+            raise ValueError('%s array must have shape (>= %d, %d), not %s' % (name, nEvents, nObjects, data.shape))
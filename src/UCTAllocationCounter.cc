@@ -0,0 +1,180 @@
+#include <new>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTAllocationCounter.hh"
+
+namespace {
+
+  const char* stageNames[UCTAllocationCounter::NStages] = {
+    "other", "input", "mask", "towers", "regions", "veto", "cards", "crates", "rings", "sumTable", "check"
+  };
+
+}
+
+const char* UCTAllocationCounter::getStageName(Stage stage) {
+  if(stage >= NStages) return "unknown";
+  return stageNames[stage];
+}
+
+#ifdef UCTCountAllocations
+
+// Per thread counters; plain data so that they need no construction before
+// the first allocation of a thread
+
+namespace {
+
+  thread_local uint64_t allocations[UCTAllocationCounter::NStages];
+  thread_local uint64_t frees[UCTAllocationCounter::NStages];
+  thread_local uint64_t bytes[UCTAllocationCounter::NStages];
+  thread_local int64_t liveBytes;
+
+  // The user part of each block is preceded by its size and its offset
+  // from the start of the block, which is larger than the header for
+  // over-aligned blocks, so that all blocks are freed the same way
+
+  const size_t headerSize = 16;
+
+  void* countedAllocate(size_t size, size_t alignment = headerSize) {
+    size_t offset = (alignment > headerSize ? alignment : headerSize);
+    void* block = 0;
+    if(alignment <= headerSize) block = malloc(size + offset);
+    else if(posix_memalign(&block, alignment, size + offset) != 0) block = 0;
+    if(block == 0) return 0;
+    size_t* header = (size_t*) ((char*) block + offset) - 2;
+    header[0] = size;
+    header[1] = offset;
+    UCTAllocationCounter::Stage stage = UCTAllocationCounter::getStage();
+    allocations[stage]++;
+    bytes[stage] += size;
+    liveBytes += size;
+    return (char*) block + offset;
+  }
+
+  void countedFree(void* p) {
+    if(p == 0) return;
+    size_t* header = (size_t*) p - 2;
+    frees[UCTAllocationCounter::getStage()]++;
+    liveBytes -= header[0];
+    free((char*) p - header[1]);
+  }
+
+}
+
+thread_local UCTAllocationCounter::Stage UCTAllocationCounter::currentStage = UCTAllocationCounter::OtherStage;
+
+bool UCTAllocationCounter::isEnabled() {return true;}
+
+UCTAllocationCounter::Counts UCTAllocationCounter::get(Stage stage) {
+  Counts counts;
+  if(stage < NStages) {
+    counts.allocations = allocations[stage];
+    counts.frees = frees[stage];
+    counts.bytes = bytes[stage];
+  }
+  return counts;
+}
+
+void UCTAllocationCounter::reset() {
+  for(uint32_t stage = 0; stage < NStages; stage++) {
+    allocations[stage] = 0;
+    frees[stage] = 0;
+    bytes[stage] = 0;
+  }
+}
+
+int64_t UCTAllocationCounter::getLiveBytes() {return liveBytes;}
+
+void* operator new(size_t size) {
+  void* p = countedAllocate(size);
+  if(p == 0) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size) {
+  void* p = countedAllocate(size);
+  if(p == 0) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {return countedAllocate(size);}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {return countedAllocate(size);}
+
+void operator delete(void* p) noexcept {countedFree(p);}
+
+void operator delete[](void* p) noexcept {countedFree(p);}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {countedFree(p);}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {countedFree(p);}
+
+// Sized deallocation (C++14) and over-aligned allocation (C++17) variants,
+// when the compiler uses them
+
+#ifdef __cpp_sized_deallocation
+
+void operator delete(void* p, size_t) noexcept {countedFree(p);}
+
+void operator delete[](void* p, size_t) noexcept {countedFree(p);}
+
+#endif
+
+#ifdef __cpp_aligned_new
+
+void* operator new(size_t size, std::align_val_t alignment) {
+  void* p = countedAllocate(size, (size_t) alignment);
+  if(p == 0) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+  void* p = countedAllocate(size, (size_t) alignment);
+  if(p == 0) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return countedAllocate(size, (size_t) alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return countedAllocate(size, (size_t) alignment);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {countedFree(p);}
+
+void operator delete[](void* p, std::align_val_t) noexcept {countedFree(p);}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {countedFree(p);}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept {countedFree(p);}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {countedFree(p);}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {countedFree(p);}
+
+#endif
+
+#else
+
+bool UCTAllocationCounter::isEnabled() {return false;}
+
+UCTAllocationCounter::Counts UCTAllocationCounter::get(Stage) {return Counts();}
+
+void UCTAllocationCounter::reset() {;}
+
+int64_t UCTAllocationCounter::getLiveBytes() {return 0;}
+
+#endif
+
+UCTAllocationCounter::Counts UCTAllocationCounter::getTotal() {
+  Counts total;
+  for(uint32_t stage = 0; stage < NStages; stage++) {
+    Counts counts = get((Stage) stage);
+    total.allocations += counts.allocations;
+    total.frees += counts.frees;
+    total.bytes += counts.bytes;
+  }
+  return total;
+}
@@ -0,0 +1,94 @@
+#ifndef UCTAllocationCounter_hh
+#define UCTAllocationCounter_hh
+
+// Heap allocation counting for instrumentation builds
+// Building the package and the stand-alone drivers with -DUCTCountAllocations
+// replaces the global operator new and delete by versions that count the
+// allocations, frees and bytes of each thread, charged to the emulator
+// stage that is current on that thread.  Stages are marked in the emulator
+// with UCTAllocationStage; everything else is charged to OtherStage.
+// In normal builds nothing is counted and the stage marks compile away.
+
+#include <stdint.h>
+#include <stddef.h>
+
+class UCTAllocationCounter {
+public:
+
+  enum Stage {OtherStage = 0, InputStage, MaskStage, TowerStage, RegionStage, VetoStage, CardStage, CrateStage,
+	      RingStage, TableStage, CheckStage, NStages};
+
+  struct Counts {
+    Counts() : allocations(0), frees(0), bytes(0) {;}
+    uint64_t allocations;
+    uint64_t frees;
+    uint64_t bytes;
+  };
+
+  static bool isEnabled();
+
+  static const char* getStageName(Stage stage);
+
+  // Counts of this thread since the last reset
+
+  static Counts get(Stage stage);
+  static Counts getTotal();
+  static void reset();
+
+  // Bytes allocated and not yet freed by this thread, not affected by reset()
+
+  static int64_t getLiveBytes();
+
+#ifdef UCTCountAllocations
+  static Stage getStage() {return currentStage;}
+  static void setStage(Stage stage) {currentStage = stage;}
+#else
+  static Stage getStage() {return OtherStage;}
+  static void setStage(Stage) {;}
+#endif
+
+private:
+
+  // No default constructor is needed
+
+  UCTAllocationCounter();
+
+#ifdef UCTCountAllocations
+  static thread_local Stage currentStage;
+#endif
+
+};
+
+// Sets the stage for the lifetime of the object and restores the previous
+// one when it goes out of scope
+
+class UCTAllocationStage {
+public:
+
+  UCTAllocationStage(UCTAllocationCounter::Stage stage) : previous(UCTAllocationCounter::getStage()) {
+    UCTAllocationCounter::setStage(stage);
+  }
+
+  ~UCTAllocationStage() {UCTAllocationCounter::setStage(previous);}
+
+  void set(UCTAllocationCounter::Stage stage) {UCTAllocationCounter::setStage(stage);}
+
+private:
+
+  // No default constructor is needed
+
+  UCTAllocationStage();
+
+  // No copy constructor is needed
+
+  UCTAllocationStage(const UCTAllocationStage&);
+
+  // No equality operator is needed
+
+  const UCTAllocationStage& operator=(const UCTAllocationStage&);
+
+  UCTAllocationCounter::Stage previous;
+
+};
+
+#endif
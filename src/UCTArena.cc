@@ -0,0 +1,91 @@
+#include <iostream>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTArena.hh"
+
+#include "UCTCrate.hh"
+#include "UCTCard.hh"
+#include "UCTRegion.hh"
+#include "UCTTower.hh"
+
+#include "UCTGeometry.hh"
+
+UCTArena::UCTArena(const size_t poolSizes[NPools]) :
+  block(0),
+  blockSize(0) {
+  for(uint32_t pool = 0; pool < NPools; pool++) {
+    poolStart[pool] = blockSize;
+    blockSize += align(poolSizes[pool]);
+    poolEnd[pool] = blockSize;
+    poolNext[pool] = poolStart[pool];
+  }
+  block = new char[blockSize + alignment];
+  // Make sure that the pool bases are aligned irrespective of new[]
+  size_t offset = (alignment - (((uintptr_t) block) & (alignment - 1))) & (alignment - 1);
+  for(uint32_t pool = 0; pool < NPools; pool++) {
+    poolStart[pool] += offset;
+    poolEnd[pool] += offset;
+    poolNext[pool] += offset;
+  }
+}
+
+UCTArena::~UCTArena() {
+  if(block != 0) delete [] block;
+}
+
+void* UCTArena::allocate(Pool pool, size_t bytes) {
+  size_t next = poolNext[pool] + align(bytes);
+  if(next > poolEnd[pool]) {
+    std::cerr << "UCTArena: Pool " << pool << " exhausted requesting " << bytes
+	      << " bytes -- bailing" << std::endl;
+    exit(1);
+  }
+  void* p = block + poolNext[pool];
+  poolNext[pool] = next;
+  return p;
+}
+
+const size_t UCTArena::used() const {
+  size_t u = 0;
+  for(uint32_t pool = 0; pool < NPools; pool++) {
+    u += poolUsed((Pool) pool);
+  }
+  return u;
+}
+
+namespace {
+
+  struct Layer1PoolSizes {
+    Layer1PoolSizes();
+    size_t sizes[UCTArena::NPools];
+  };
+
+}
+
+const size_t* UCTArena::getLayer1PoolSizes() {
+  static const Layer1PoolSizes layer1PoolSizes;
+  return layer1PoolSizes.sizes;
+}
+
+Layer1PoolSizes::Layer1PoolSizes() {
+  size_t* poolSizes = sizes;
+  UCTGeometry g;
+  uint32_t nCards = g.getNCrates() * g.getNCards();
+  uint32_t nRegionsInCard = NSides * g.getNRegions();
+  uint32_t nTowersInCard = 0;
+  for(uint32_t rgn = 0; rgn < g.getNRegions(); rgn++) {
+    nTowersInCard += NSides * g.getNEta(rgn) * g.getNPhi(rgn);
+  }
+  poolSizes[UCTArena::TowerPool] = nCards * nTowersInCard * UCTArena::align(sizeof(UCTTower));
+  poolSizes[UCTArena::RegionPool] = nCards * nRegionsInCard * UCTArena::align(sizeof(UCTRegion));
+  poolSizes[UCTArena::CardPool] = nCards * UCTArena::align(sizeof(UCTCard));
+  poolSizes[UCTArena::CratePool] = g.getNCrates() * UCTArena::align(sizeof(UCTCrate));
+  // Pointer lists: one per region for towers, one per card for regions,
+  // one per crate for cards and one for the crates themselves
+  poolSizes[UCTArena::ListPool] =
+    nCards * nRegionsInCard * UCTArena::align(g.getNEta(0) * g.getNPhi(0) * sizeof(UCTTower*)) +
+    nCards * UCTArena::align(nRegionsInCard * sizeof(UCTRegion*)) +
+    g.getNCrates() * UCTArena::align(g.getNCards() * sizeof(UCTCard*)) +
+    UCTArena::align(g.getNCrates() * sizeof(UCTCrate*));
+}
@@ -0,0 +1,106 @@
+#ifndef UCTArena_hh
+#define UCTArena_hh
+
+// UCT emulator object arena
+// All crates, cards, regions and towers of one UCTLayer1 instance, and the
+// pointer lists that link them, are placed in a single block of memory
+// that is allocated once at construction and released once at destruction.
+// The block is split into pools, one per object type, so that objects of
+// the same type are contiguous in construction order.
+// Memory is handed out by bumping a pointer; nothing is freed individually.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+class UCTArena {
+public:
+
+  enum Pool {TowerPool = 0, RegionPool, CardPool, CratePool, ListPool, NPools};
+
+  UCTArena(const size_t poolSizes[NPools]);
+
+  virtual ~UCTArena();
+
+  void* allocate(Pool pool, size_t bytes);
+
+  template<typename T> void* allocate(Pool pool) {return allocate(pool, sizeof(T));}
+
+  // Pool access - objects of one type are contiguous from the pool base
+
+  const void* poolBase(Pool pool) const {return (block + poolStart[pool]);}
+  const size_t poolUsed(Pool pool) const {return poolNext[pool] - poolStart[pool];}
+
+  const size_t size() const {return blockSize;}
+  const size_t used() const;
+
+  // Pool sizes needed for the full Layer-1 geometry
+
+  static const size_t* getLayer1PoolSizes();
+
+  static const size_t alignment = 16;
+
+  static size_t align(size_t bytes) {return (bytes + alignment - 1) & ~(alignment - 1);}
+
+private:
+
+  // No default constructor is needed
+
+  UCTArena();
+
+  // No copy constructor is needed
+
+  UCTArena(const UCTArena&);
+
+  // No equality operator is needed
+
+  const UCTArena& operator=(const UCTArena&);
+
+  char* block;
+  size_t blockSize;
+
+  size_t poolStart[NPools];
+  size_t poolEnd[NPools];
+  size_t poolNext[NPools];
+
+};
+
+// Allocator for the child pointer lists held by the emulator objects
+// Deallocation is a no-op as the arena releases its block in one go
+
+template<typename T>
+class UCTArenaAllocator {
+public:
+
+  typedef T value_type;
+
+  UCTArenaAllocator(UCTArena& a) : arena(&a) {;}
+  template<typename U> UCTArenaAllocator(const UCTArenaAllocator<U>& o) : arena(o.arena) {;}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena->allocate(UCTArena::ListPool, n * sizeof(T)));
+  }
+  void deallocate(T*, size_t) {;}
+
+  template<typename U> struct rebind {typedef UCTArenaAllocator<U> other;};
+
+  UCTArena* arena;
+
+};
+
+template<typename T, typename U>
+bool operator==(const UCTArenaAllocator<T>& a, const UCTArenaAllocator<U>& b) {return a.arena == b.arena;}
+template<typename T, typename U>
+bool operator!=(const UCTArenaAllocator<T>& a, const UCTArenaAllocator<U>& b) {return a.arena != b.arena;}
+
+class UCTCrate;
+class UCTCard;
+class UCTRegion;
+class UCTTower;
+
+typedef std::vector<UCTCrate*, UCTArenaAllocator<UCTCrate*> > UCTCrateList;
+typedef std::vector<UCTCard*, UCTArenaAllocator<UCTCard*> > UCTCardList;
+typedef std::vector<UCTRegion*, UCTArenaAllocator<UCTRegion*> > UCTRegionList;
+typedef std::vector<UCTTower*, UCTArenaAllocator<UCTTower*> > UCTTowerList;
+
+#endif
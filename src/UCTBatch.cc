@@ -0,0 +1,116 @@
+#include <iostream>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTBatch.hh"
+
+#include "UCTLayer1.hh"
+#include "UCTCrate.hh"
+#include "UCTCard.hh"
+#include "UCTRegion.hh"
+#include "UCTTower.hh"
+
+UCTBatch::UCTBatch(UCTLayer1& layer1) {
+  towerTable.assign((2 * MaxCaloEta + 1) * (MaxCaloPhi + 1), NoBatchTower);
+  const UCTCrateList& crates = layer1.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    crateFirstCard.push_back(cardFirstRegion.size());
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      cardFirstRegion.push_back(regions.size());
+      const UCTRegionList& cardRegions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < cardRegions.size(); rgn++) {
+	regionFirstTower.push_back(towers.size());
+	regions.push_back(cardRegions[rgn]);
+	const UCTTowerList& regionTowers = cardRegions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < regionTowers.size(); twr++) {
+	  UCTTowerIndex t = regionTowers[twr]->towerIndex();
+	  towerTable[(t.first + MaxCaloEta) * (MaxCaloPhi + 1) + t.second] = towers.size();
+	  towers.push_back(regionTowers[twr]);
+	  towerIndices.push_back(t);
+	}
+      }
+    }
+  }
+  regionFirstTower.push_back(towers.size());
+  cardFirstRegion.push_back(regions.size());
+  crateFirstCard.push_back(cardFirstRegion.size() - 1);
+  towerInputs.assign(towers.size() * BatchLanes, 0);
+  towerData.assign(towers.size() * BatchLanes, 0);
+  regionData.assign(regions.size() * BatchLanes, 0);
+  cardET.assign((cardFirstRegion.size() - 1) * BatchLanes, 0);
+  crateET.assign((crateFirstCard.size() - 1) * BatchLanes, 0);
+  summaries.assign(BatchLanes, 0);
+}
+
+bool UCTBatch::clearEvent() {
+  std::fill(towerInputs.begin(), towerInputs.end(), 0);
+  return true;
+}
+
+bool UCTBatch::setECALData(uint32_t lane, const int* caloEta, const int* caloPhi,
+			   const uint32_t* et, const uint32_t* flag, uint32_t nTPs) {
+  return setTPs(lane, caloEta, caloPhi, et, flag, nTPs, true);
+}
+
+bool UCTBatch::setHCALData(uint32_t lane, const int* caloEta, const int* caloPhi,
+			   const uint32_t* et, const uint32_t* flag, uint32_t nTPs) {
+  return setTPs(lane, caloEta, caloPhi, et, flag, nTPs, false);
+}
+
+bool UCTBatch::setTPs(uint32_t lane, const int* caloEta, const int* caloPhi,
+		      const uint32_t* et, const uint32_t* flag, uint32_t nTPs, bool isECAL) {
+  if(lane >= BatchLanes) {
+    std::cerr << "UCTBatch::setTPs - Invalid lane " << lane << std::endl;
+    return false;
+  }
+  for(uint32_t i = 0; i < nTPs; i++) {
+    if(et[i] == 0) continue;
+    uint32_t tower = NoBatchTower;
+    if(abs(caloEta[i]) <= MaxCaloEta && caloPhi[i] >= 1 && caloPhi[i] <= MaxCaloPhi)
+      tower = towerTable[(caloEta[i] + MaxCaloEta) * (MaxCaloPhi + 1) + caloPhi[i]];
+    if(tower == NoBatchTower) {
+      std::cerr << "UCTBatch::setTPs - Invalid (caloEta, caloPhi) = (" << std::dec
+		<< caloEta[i] << ", " << caloPhi[i] << ")" << std::endl;
+      return false;
+    }
+    // Input words as UCTTower::inputData()
+    uint32_t& input = towerInputs[tower * BatchLanes + lane];
+    uint32_t tpET = std::min(et[i], (uint32_t) 0xFF);
+    if(isECAL) input = ((input & 0x003FFF00) | tpET | (flag[i] != 0 ? 0x00400000 : 0));
+    else input = ((input & 0x004000FF) | (tpET << 8) | ((flag[i] & 0x3F) << 16));
+  }
+  return true;
+}
+
+bool UCTBatch::process() {
+
+  // Towers and regions, all lanes at once
+
+  for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+    uint32_t first = regionFirstTower[rgn] * BatchLanes;
+    if(!regions[rgn]->process(&towerInputs[first], &towerData[first], &regionData[rgn * BatchLanes])) return false;
+  }
+
+  // Card, crate and total ET sums
+
+  std::fill(cardET.begin(), cardET.end(), 0);
+  std::fill(crateET.begin(), crateET.end(), 0);
+  std::fill(summaries.begin(), summaries.end(), 0);
+  for(uint32_t crt = 0; crt + 1 < crateFirstCard.size(); crt++) {
+    uint32_t* crateSum = &crateET[crt * BatchLanes];
+    for(uint32_t crd = crateFirstCard[crt]; crd < crateFirstCard[crt + 1]; crd++) {
+      uint32_t* cardSum = &cardET[crd * BatchLanes];
+      for(uint32_t rgn = cardFirstRegion[crd]; rgn < cardFirstRegion[crd + 1]; rgn++) {
+	const uint32_t* region = &regionData[rgn * BatchLanes];
+	for(uint32_t l = 0; l < BatchLanes; l++) cardSum[l] += (region[l] & RegionETMask);
+      }
+      for(uint32_t l = 0; l < BatchLanes; l++) crateSum[l] += cardSum[l];
+    }
+    for(uint32_t l = 0; l < BatchLanes; l++) summaries[l] += crateSum[l];
+  }
+
+  return true;
+
+}
@@ -0,0 +1,111 @@
+#ifndef UCTBatch_hh
+#define UCTBatch_hh
+
+// UCT cross-event batch processing
+// Processes BatchLanes events at once with the calibration and channel
+// masks of one UCTLayer1 instance, for throughput when re-emulating large
+// captures.  Each event is a lane, and the data of all objects are kept
+// object-major with the lanes of one object contiguous:
+//   towerInputs[tower * BatchLanes + lane]
+// with the towers, regions, cards and crates in the UCTLayer1 hierarchy
+// order.  Each tower and region is visited once per batch; the lane
+// versions of UCTTower::process() and UCTRegion::process() are branch-free
+// loops over the lanes, which the compiler vectorizes, and the region
+// veto patterns of all lanes are decided together with one bit per lane.
+// Unused lanes are processed as empty events.
+// The towers, regions, cards and crates are bit-identical to those of
+// UCTLayer1::process(); the ring sums and the optional products of
+// UCTLayer1 are not made.
+
+#include <vector>
+#include <stdint.h>
+
+#include "UCTGeometry.hh"
+#include "UCTTower.hh"
+
+class UCTLayer1;
+class UCTRegion;
+
+#define NoBatchTower 0xFFFFFFFF
+
+class UCTBatch {
+public:
+
+  UCTBatch(UCTLayer1& layer1);
+
+  virtual ~UCTBatch() {;}
+
+  const uint32_t getNTowers() const {return towers.size();}
+  const uint32_t getNRegions() const {return regions.size();}
+  const uint32_t getNCards() const {return cardFirstRegion.size() - 1;}
+  const uint32_t getNCrates() const {return crateFirstCard.size() - 1;}
+
+  // To zero out all lanes
+
+  bool clearEvent();
+
+  // Bulk setting of (caloEta, caloPhi, et, flag) arrays of TPs of one
+  // lane, as UCTLayer1::setECALData() and setHCALData(): zero ET TPs are
+  // dropped, ET is pegged to 0xFF and only 6 HCAL feature bits are kept
+
+  bool setECALData(uint32_t lane, const int* caloEta, const int* caloPhi,
+		   const uint32_t* et, const uint32_t* flag, uint32_t nTPs);
+  bool setHCALData(uint32_t lane, const int* caloEta, const int* caloPhi,
+		   const uint32_t* et, const uint32_t* flag, uint32_t nTPs);
+
+  bool process();
+
+  // De-interleaved results of one lane, as UCTTower::rawData(),
+  // UCTRegion::rawData(), UCTCard::et(), UCTCrate::et() and UCTLayer1::et()
+
+  const uint32_t getTowerData(uint32_t lane, uint32_t tower) const {return towerData[tower * BatchLanes + lane];}
+  const uint32_t getRegionData(uint32_t lane, uint32_t region) const {return regionData[region * BatchLanes + lane];}
+  const uint32_t getCardET(uint32_t lane, uint32_t card) const {return cardET[card * BatchLanes + lane];}
+  const uint32_t getCrateET(uint32_t lane, uint32_t crate) const {return crateET[crate * BatchLanes + lane];}
+  const uint32_t getSummary(uint32_t lane) const {return summaries[lane];}
+
+  // (caloEta, caloPhi) of a tower
+
+  const UCTTowerIndex& getTowerIndex(uint32_t tower) const {return towerIndices[tower];}
+
+private:
+
+  // No default constructor is needed
+
+  UCTBatch();
+
+  // No copy constructor is needed
+
+  UCTBatch(const UCTBatch&);
+
+  // No equality operator is needed
+
+  const UCTBatch& operator=(const UCTBatch&);
+
+  bool setTPs(uint32_t lane, const int* caloEta, const int* caloPhi,
+	      const uint32_t* et, const uint32_t* flag, uint32_t nTPs, bool isECAL);
+
+  // Objects in hierarchy order; each region's towers and each card's
+  // regions are consecutive
+
+  std::vector<const UCTTower*> towers;
+  std::vector<UCTTowerIndex> towerIndices;
+  std::vector<const UCTRegion*> regions;
+  std::vector<uint32_t> regionFirstTower;
+  std::vector<uint32_t> cardFirstRegion;
+  std::vector<uint32_t> crateFirstCard;
+
+  // (caloEta, caloPhi) to tower number look-up; NoBatchTower where none
+
+  std::vector<uint32_t> towerTable;
+
+  std::vector<uint32_t> towerInputs;
+  std::vector<uint32_t> towerData;
+  std::vector<uint32_t> regionData;
+  std::vector<uint32_t> cardET;
+  std::vector<uint32_t> crateET;
+  std::vector<uint32_t> summaries;
+
+};
+
+#endif
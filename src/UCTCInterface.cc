@@ -0,0 +1,139 @@
+#include <iostream>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTCInterface.hh"
+
+#include "UCTLayer1.hh"
+#include "UCTCrate.hh"
+#include "UCTCard.hh"
+#include "UCTRegion.hh"
+#include "UCTTower.hh"
+
+UCTLayer1* uctCreate() {
+  return new UCTLayer1;
+}
+
+void uctDestroy(UCTLayer1* uct) {
+  delete uct;
+}
+
+uint32_t uctGetNTowers(UCTLayer1* uct) {
+  uint32_t n = 0;
+  const UCTCrateList& crates = uct->getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	n += regions[rgn]->getTowers().size();
+      }
+    }
+  }
+  return n;
+}
+
+uint32_t uctGetNRegions(UCTLayer1* uct) {
+  uint32_t n = 0;
+  const UCTCrateList& crates = uct->getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      n += cards[crd]->getRegions().size();
+    }
+  }
+  return n;
+}
+
+bool uctGetTowerIndices(UCTLayer1* uct, int* caloEta, int* caloPhi) {
+  uint32_t i = 0;
+  const UCTCrateList& crates = uct->getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++, i++) {
+	  caloEta[i] = towers[twr]->caloEta();
+	  caloPhi[i] = towers[twr]->caloPhi();
+	}
+      }
+    }
+  }
+  return true;
+}
+
+bool uctGetRegionIndices(UCTLayer1* uct, int* regionEta, int* regionPhi) {
+  uint32_t i = 0;
+  const UCTCrateList& crates = uct->getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++, i++) {
+	UCTRegionIndex r = regions[rgn]->regionIndex();
+	regionEta[i] = r.first;
+	regionPhi[i] = r.second;
+      }
+    }
+  }
+  return true;
+}
+
+namespace {
+
+  bool checkOffsets(const char* name, const uint32_t* offsets, uint32_t nEvents, uint32_t nTPs) {
+    for(uint32_t e = 0; e < nEvents; e++) {
+      if(offsets[e + 1] < offsets[e]) {
+	std::cerr << "uctProcessBatch: " << name << " offsets decrease at event " << e << std::endl;
+	return false;
+      }
+    }
+    if(offsets[nEvents] > nTPs) {
+      std::cerr << "uctProcessBatch: " << name << " offsets run past the " << nTPs << " TPs" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+}
+
+bool uctProcessBatch(UCTLayer1* uct, uint32_t nEvents,
+		     const uint32_t* ecalOffsets, uint32_t nECALTPs, const int* ecalEta, const int* ecalPhi,
+		     const uint32_t* ecalET, const uint32_t* ecalFG,
+		     const uint32_t* hcalOffsets, uint32_t nHCALTPs, const int* hcalEta, const int* hcalPhi,
+		     const uint32_t* hcalET, const uint32_t* hcalFB,
+		     uint32_t* towerData, uint32_t* regionData, uint32_t* summaries) {
+  if(!checkOffsets("ECAL", ecalOffsets, nEvents, nECALTPs) ||
+     !checkOffsets("HCAL", hcalOffsets, nEvents, nHCALTPs)) return false;
+  const UCTCrateList& crates = uct->getCrates();
+  for(uint32_t e = 0; e < nEvents; e++) {
+    uint32_t e0 = ecalOffsets[e];
+    uint32_t h0 = hcalOffsets[e];
+    if(!uct->clearEvent() ||
+       !uct->setECALData(&ecalEta[e0], &ecalPhi[e0], &ecalET[e0], &ecalFG[e0], ecalOffsets[e + 1] - e0) ||
+       !uct->setHCALData(&hcalEta[h0], &hcalPhi[h0], &hcalET[h0], &hcalFB[h0], hcalOffsets[e + 1] - h0) ||
+       !uct->process()) {
+      std::cerr << "uctProcessBatch: Failed to process event " << e << " of the batch" << std::endl;
+      return false;
+    }
+    if(summaries != 0) summaries[e] = uct->getSummary();
+    if(towerData == 0 && regionData == 0) continue;
+    for(uint32_t crt = 0; crt < crates.size(); crt++) {
+      const UCTCardList& cards = crates[crt]->getCards();
+      for(uint32_t crd = 0; crd < cards.size(); crd++) {
+	const UCTRegionList& regions = cards[crd]->getRegions();
+	for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	  if(regionData != 0) *regionData++ = regions[rgn]->rawData();
+	  if(towerData == 0) continue;
+	  const UCTTowerList& towers = regions[rgn]->getTowers();
+	  for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	    *towerData++ = towers[twr]->rawData();
+	  }
+	}
+      }
+    }
+  }
+  return true;
+}
@@ -0,0 +1,45 @@
+#ifndef UCTCInterface_hh
+#define UCTCInterface_hh
+
+// UCT C interface for batch emulation from other languages
+// Plain C functions on an opaque UCTLayer1 handle, meant for Python
+// ctypes (see python/uctEmulator.py), which releases the GIL during the
+// calls.  All arrays are owned by the caller and used in place.
+//
+// Sparse TPs of a batch of nEvents events are given as flat arrays of
+// nTPs entries with per-event offsets: the TPs of event e are
+// [offsets[e], offsets[e + 1]).  Offsets must not decrease and must stay
+// within the nTPs entries, or the batch is rejected before processing.
+// ECAL flags are the fine grain bits and HCAL flags the feature bits.
+// Outputs are written per event in the UCTLayer1 hierarchy order
+// (crate, card, region, tower), as labelled by uctGetTowerIndices() and
+// uctGetRegionIndices():
+//   towerData[e * nTowers + i]    packed UCTTower::rawData()
+//   regionData[e * nRegions + i]  packed UCTRegion::rawData()
+//   summaries[e]                  UCTLayer1::getSummary()
+// Null output arrays are skipped.
+
+#include <stdint.h>
+
+class UCTLayer1;
+
+extern "C" {
+
+  UCTLayer1* uctCreate();
+  void uctDestroy(UCTLayer1* uct);
+
+  uint32_t uctGetNTowers(UCTLayer1* uct);
+  uint32_t uctGetNRegions(UCTLayer1* uct);
+  bool uctGetTowerIndices(UCTLayer1* uct, int* caloEta, int* caloPhi);
+  bool uctGetRegionIndices(UCTLayer1* uct, int* regionEta, int* regionPhi);
+
+  bool uctProcessBatch(UCTLayer1* uct, uint32_t nEvents,
+		       const uint32_t* ecalOffsets, uint32_t nECALTPs, const int* ecalEta, const int* ecalPhi,
+		       const uint32_t* ecalET, const uint32_t* ecalFG,
+		       const uint32_t* hcalOffsets, uint32_t nHCALTPs, const int* hcalEta, const int* hcalPhi,
+		       const uint32_t* hcalET, const uint32_t* hcalFB,
+		       uint32_t* towerData, uint32_t* regionData, uint32_t* summaries);
+
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include <iostream>
+#include <fstream>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "UCTCalibrationLUT.hh"
+
+UCTCalibrationLUT::UCTCalibrationLUT() :
+  lutVersion(0),
+  mapping(0),
+  mappingSize(0),
+  payload(0) {
+}
+
+UCTCalibrationLUT::~UCTCalibrationLUT() {
+  unload();
+}
+
+bool UCTCalibrationLUT::load(const std::string& name) {
+  unload();
+  int fd = open(name.c_str(), O_RDONLY);
+  if(fd < 0) {
+    std::cerr << "UCTCalibrationLUT: Unable to open " << name << std::endl;
+    return false;
+  }
+  struct stat fileStat;
+  size_t expectedSize = headerWords * sizeof(uint32_t) + NLUTWords;
+  if(fstat(fd, &fileStat) != 0 || (size_t) fileStat.st_size != expectedSize) {
+    std::cerr << "UCTCalibrationLUT: " << name << " has wrong size; expected "
+	      << expectedSize << " bytes" << std::endl;
+    close(fd);
+    return false;
+  }
+  void* m = mmap(0, expectedSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(m == MAP_FAILED) {
+    std::cerr << "UCTCalibrationLUT: Unable to map " << name << std::endl;
+    return false;
+  }
+  const uint32_t* header = (const uint32_t*) m;
+  const uint8_t* data = ((const uint8_t*) m) + headerWords * sizeof(uint32_t);
+  if(header[0] != magic || header[1] != formatVersion ||
+     header[3] != NLUTEta || header[4] != NLUTPhi || header[5] != NLUTEntries) {
+    std::cerr << "UCTCalibrationLUT: " << name << " header is not recognized" << std::endl;
+    munmap(m, expectedSize);
+    return false;
+  }
+  if(header[6] != checksum(data, NLUTWords)) {
+    std::cerr << "UCTCalibrationLUT: " << name << " checksum mismatch" << std::endl;
+    munmap(m, expectedSize);
+    return false;
+  }
+  fileName = name;
+  lutVersion = header[2];
+  mapping = m;
+  mappingSize = expectedSize;
+  payload = data;
+  return true;
+}
+
+void UCTCalibrationLUT::unload() {
+  if(mapping != 0) munmap(mapping, mappingSize);
+  mapping = 0;
+  mappingSize = 0;
+  payload = 0;
+  lutVersion = 0;
+  fileName.clear();
+}
+
+bool UCTCalibrationLUT::write(const std::string& name, uint32_t version, const std::vector<uint8_t>& tables) {
+  if(tables.size() != NLUTWords) {
+    std::cerr << "UCTCalibrationLUT: Tables have " << tables.size() << " entries; "
+	      << NLUTWords << " expected" << std::endl;
+    return false;
+  }
+  uint32_t header[headerWords] = 
+    {magic, formatVersion, version, NLUTEta, NLUTPhi, NLUTEntries, checksum(&tables[0], tables.size()), 0};
+  std::ofstream out(name.c_str(), std::ios::binary);
+  out.write((const char*) header, sizeof(header));
+  out.write((const char*) &tables[0], tables.size());
+  if(!out.good()) {
+    std::cerr << "UCTCalibrationLUT: Unable to write " << name << std::endl;
+    return false;
+  }
+  return true;
+}
+
+uint32_t UCTCalibrationLUT::checksum(const uint8_t* data, size_t size) {
+  // Adler-32, reducing modulo 65521 every 5552 bytes to avoid overflow
+  uint32_t a = 1;
+  uint32_t b = 0;
+  while(size > 0) {
+    size_t n = (size < 5552 ? size : 5552);
+    size -= n;
+    for(size_t i = 0; i < n; i++) {
+      a += data[i];
+      b += a;
+    }
+    data += n;
+    a %= 65521;
+    b %= 65521;
+  }
+  return ((b << 16) | a);
+}
@@ -0,0 +1,83 @@
+#ifndef UCTCalibrationLUT_hh
+#define UCTCalibrationLUT_hh
+
+// UCT per-tower ECAL and HCAL calibration look-up tables
+// For each tower (caloEta, caloPhi) there is one ECAL and one HCAL table
+// mapping the 8-bit compressed ET to the 8-bit calibrated ET
+// HF towers only use their HCAL table
+//
+// Tables are loaded read-only via mmap from a binary file:
+//   Header of 8 x 32-bit words (host order):
+//     magic, format version, LUT version, nEta, nPhi, nEntries, checksum, 0
+//   Payload of nEntries byte tables indexed by
+//     [detector (0 = ECAL, 1 = HCAL)][caloEta + MaxCaloEta][caloPhi]
+// The checksum is the Adler-32 of the payload
+//
+// The emulator only keeps pointers into the tables, so LUT sets can be
+// swapped between runs with UCTLayer1::setCalibrationLUT()
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "UCTGeometry.hh"
+
+#define NLUTEntries 256
+#define NLUTEta (2 * MaxCaloEta + 1)
+#define NLUTPhi (MaxCaloPhi + 1)
+#define NLUTWords (2 * NLUTEta * NLUTPhi * NLUTEntries)
+
+class UCTCalibrationLUT {
+public:
+
+  UCTCalibrationLUT();
+
+  virtual ~UCTCalibrationLUT();
+
+  bool load(const std::string& fileName);
+  void unload();
+
+  bool isLoaded() const {return (payload != 0);}
+  const uint32_t getVersion() const {return lutVersion;}
+  const std::string& getFileName() const {return fileName;}
+
+  const uint8_t* getECALLUT(int caloEta, int caloPhi) const {return getLUT(0, caloEta, caloPhi);}
+  const uint8_t* getHCALLUT(int caloEta, int caloPhi) const {return getLUT(1, caloEta, caloPhi);}
+
+  // To produce a LUT file from tables in the payload layout above
+
+  static bool write(const std::string& fileName, uint32_t lutVersion, const std::vector<uint8_t>& tables);
+
+  static uint32_t checksum(const uint8_t* data, size_t size);
+
+  static const uint32_t magic = 0x5543544C;
+  static const uint32_t formatVersion = 1;
+  static const uint32_t headerWords = 8;
+
+private:
+
+  // No copy constructor is needed
+
+  UCTCalibrationLUT(const UCTCalibrationLUT&);
+
+  // No equality operator is needed
+
+  const UCTCalibrationLUT& operator=(const UCTCalibrationLUT&);
+
+  const uint8_t* getLUT(uint32_t detector, int caloEta, int caloPhi) const {
+    if(payload == 0 || caloEta < -MaxCaloEta || caloEta > MaxCaloEta || 
+       caloPhi < 0 || caloPhi > MaxCaloPhi) return 0;
+    return payload + ((detector * NLUTEta + (caloEta + MaxCaloEta)) * NLUTPhi + caloPhi) * NLUTEntries;
+  }
+
+  std::string fileName;
+  uint32_t lutVersion;
+
+  void* mapping;
+  size_t mappingSize;
+  const uint8_t* payload;
+
+};
+
+#endif
@@ -1,34 +1,59 @@
 #include <iostream>
 #include <stdlib.h>
 #include <stdint.h>
+#include <new>
 
 #include "UCTCard.hh"
 #include "UCTRegion.hh"
 #include "UCTGeometry.hh"
 
-UCTCard::UCTCard(uint32_t crt, uint32_t crd) :
+UCTCard::UCTCard(uint32_t crt, uint32_t crd, UCTArena& arena) :
   crate(crt),
   card(crd),
+  regions(UCTArenaAllocator<UCTRegion*>(arena)),
   cardSummary(0) {
   UCTGeometry g;
+  regions.reserve(NSides * g.getNRegions());
   for(uint32_t rgn = 0; rgn < g.getNRegions(); rgn++) {
     // Negative eta side
-    regions.push_back(new UCTRegion(crate, card, true, rgn));
+    void* p = arena.allocate<UCTRegion>(UCTArena::RegionPool);
+    regions.push_back(new (p) UCTRegion(crate, card, true, rgn, arena));
     // Positive eta side
-    regions.push_back(new UCTRegion(crate, card, false, rgn));
+    p = arena.allocate<UCTRegion>(UCTArena::RegionPool);
+    regions.push_back(new (p) UCTRegion(crate, card, false, rgn, arena));
   }
 }
 
 UCTCard::~UCTCard() {
+  // Regions live in the arena; only their destructors are run here
   for(uint32_t i = 0; i < regions.size(); i++) {
-    if(regions[i] != 0) delete regions[i];
+    if(regions[i] != 0) regions[i]->~UCTRegion();
   }
 }
 
-bool UCTCard::process() {
+bool UCTCard::process(bool withVetoBits) {
+  // Regions are in (negative, positive) eta pairs by region number, so
+  // each region shape is a contiguous range with its own kernel
+  cardSummary = 0;
+  uint32_t i = 0;
+  for(; i < NSides * CaloHFRegionStart; i++) {
+    if(!regions[i]->process<NEtaInRegion, NPhiInRegion, true>(withVetoBits)) return false;
+    cardSummary += regions[i]->et();
+  }
+  for(; i < NSides * CaloVHFRegionStart; i++) {
+    if(!regions[i]->process<NHFEtaInRegion, NHFPhiInRegion, false>()) return false;
+    cardSummary += regions[i]->et();
+  }
+  for(; i < regions.size(); i++) {
+    if(!regions[i]->process<NHFEtaInRegion, NVHFPhiInCard, false>()) return false;
+    cardSummary += regions[i]->et();
+  }
+  return true;
+}
+
+bool UCTCard::summarize() {
   cardSummary = 0;
   for(uint32_t i = 0; i < regions.size(); i++) {
-    if(regions[i] != 0) regions[i]->process();
     cardSummary += regions[i]->et();
   }
   return true;
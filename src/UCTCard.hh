@@ -4,19 +4,20 @@
 #include <vector>
 
 #include "UCTGeometry.hh"
+#include "UCTArena.hh"
 
 class UCTRegion;
 
 class UCTCard {
 public:
 
-  UCTCard(uint32_t crt, uint32_t crd);
+  UCTCard(uint32_t crt, uint32_t crd, UCTArena& arena);
 
   virtual ~UCTCard();
 
   // To set up event data before processing
 
-  const std::vector<UCTRegion*>& getRegions() const {return regions;}
+  const UCTRegionList& getRegions() const {return regions;}
   const UCTRegion* getRegion(uint32_t rgn) const {return regions[rgn];}
   const UCTRegion* getRegion(UCTRegionIndex r) const;
 
@@ -28,7 +29,18 @@ public:
   bool setEventData(UCTTowerIndex t,
 		    bool ecalFG, uint32_t ecalET, 
 		    uint32_t hcalFB, uint32_t hcalET);
-  bool process();
+  // Without vetoBits the veto bits of the central regions are left clear,
+  // for UCTRegionVeto
+
+  bool process(bool vetoBits = true);
+
+  // To recompute the summary from already processed regions only
+
+  bool summarize();
+
+  // To restore a previously processed state
+
+  bool setState(uint32_t summary) {cardSummary = summary; return true;}
 
   // More access functions
 
@@ -62,7 +74,7 @@ private:
   uint32_t crate;
   uint32_t card;
 
-  std::vector<UCTRegion*> regions;
+  UCTRegionList regions;
 
   uint32_t cardSummary;
 
@@ -0,0 +1,62 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTChannelMask.hh"
+
+UCTChannelMask::UCTChannelMask() :
+  masks((2 * MaxCaloEta + 1) * (MaxCaloPhi + 1), 0),
+  nMasked(0) {
+}
+
+void UCTChannelMask::clear() {
+  std::fill(masks.begin(), masks.end(), 0);
+  nMasked = 0;
+  fileName.clear();
+}
+
+bool UCTChannelMask::setMask(int caloEta, int caloPhi, bool ecalMasked, bool hcalMasked) {
+  if(caloEta < -MaxCaloEta || caloEta > MaxCaloEta || caloEta == 0 || caloPhi < 1 || caloPhi > MaxCaloPhi) {
+    std::cerr << "UCTChannelMask::setMask - Invalid (caloEta, caloPhi) = (" 
+	      << caloEta << ", " << caloPhi << ")" << std::endl;
+    return false;
+  }
+  uint8_t& mask = masks[(caloEta + MaxCaloEta) * (MaxCaloPhi + 1) + caloPhi];
+  if(mask != 0) nMasked--;
+  mask = (ecalMasked ? ECALChannelMask : 0) | (hcalMasked ? HCALChannelMask : 0);
+  if(mask != 0) nMasked++;
+  return true;
+}
+
+bool UCTChannelMask::load(const std::string& name) {
+  clear();
+  std::ifstream file(name.c_str());
+  if(!file) {
+    std::cerr << "UCTChannelMask::load - Cannot open " << name << std::endl;
+    return false;
+  }
+  std::string line;
+  uint32_t lineNumber = 0;
+  while(std::getline(file, line)) {
+    lineNumber++;
+    size_t comment = line.find('#');
+    if(comment != std::string::npos) line.erase(comment);
+    std::istringstream fields(line);
+    int caloEta;
+    if(!(fields >> caloEta)) continue; // Blank line
+    int caloPhi;
+    int ecalMasked;
+    int hcalMasked;
+    if(!(fields >> caloPhi >> ecalMasked >> hcalMasked) || 
+       !setMask(caloEta, caloPhi, (ecalMasked != 0), (hcalMasked != 0))) {
+      std::cerr << "UCTChannelMask::load - Bad line " << lineNumber << " in " << name << std::endl;
+      clear();
+      return false;
+    }
+  }
+  fileName = name;
+  return true;
+}
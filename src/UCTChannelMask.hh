@@ -0,0 +1,61 @@
+#ifndef UCTChannelMask_hh
+#define UCTChannelMask_hh
+
+// UCT dead/hot channel mask
+// One ECAL and one HCAL mask bit per tower (caloEta, caloPhi), with
+// caloPhi in the segmentation of the tower as elsewhere in the emulator.
+// Masks are read from a text file with one masked tower per line:
+//   caloEta caloPhi ecalMasked hcalMasked
+// where the last two are 0 or 1; everything after a '#' is a comment.
+// UCTLayer1::setChannelMask() hands the masks to the towers, which AND
+// their inputs with them while processing.
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include "UCTGeometry.hh"
+
+#define ECALChannelMask 0x1
+#define HCALChannelMask 0x2
+
+class UCTChannelMask {
+public:
+
+  UCTChannelMask();
+
+  virtual ~UCTChannelMask() {;}
+
+  bool load(const std::string& fileName);
+  void clear();
+
+  bool setMask(int caloEta, int caloPhi, bool ecalMasked, bool hcalMasked);
+
+  bool isECALMasked(int caloEta, int caloPhi) const {return ((getMask(caloEta, caloPhi) & ECALChannelMask) != 0);}
+  bool isHCALMasked(int caloEta, int caloPhi) const {return ((getMask(caloEta, caloPhi) & HCALChannelMask) != 0);}
+
+  const uint32_t getNMasked() const {return nMasked;}
+  const std::string& getFileName() const {return fileName;}
+
+private:
+
+  // No copy constructor is needed
+
+  UCTChannelMask(const UCTChannelMask&);
+
+  // No equality operator is needed
+
+  const UCTChannelMask& operator=(const UCTChannelMask&);
+
+  uint8_t getMask(int caloEta, int caloPhi) const {
+    if(caloEta < -MaxCaloEta || caloEta > MaxCaloEta || caloPhi < 0 || caloPhi > MaxCaloPhi) return 0;
+    return masks[(caloEta + MaxCaloEta) * (MaxCaloPhi + 1) + caloPhi];
+  }
+
+  std::string fileName;
+  std::vector<uint8_t> masks;
+  uint32_t nMasked;
+
+};
+
+#endif
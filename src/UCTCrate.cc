@@ -1,23 +1,28 @@
 #include <iostream>
 #include <stdlib.h>
 #include <stdint.h>
+#include <new>
 
 #include "UCTCrate.hh"
 #include "UCTCard.hh"
 #include "UCTGeometry.hh"
 
-UCTCrate::UCTCrate(uint32_t crt) :
+UCTCrate::UCTCrate(uint32_t crt, UCTArena& arena) :
   crate(crt),
+  cards(UCTArenaAllocator<UCTCard*>(arena)),
   crateSummary(0) {
   UCTGeometry g;
+  cards.reserve(g.getNCards());
   for(uint32_t card = 0; card < g.getNCards(); card++) {
-    cards.push_back(new UCTCard(crate, card));
+    void* p = arena.allocate<UCTCard>(UCTArena::CardPool);
+    cards.push_back(new (p) UCTCard(crate, card, arena));
   }
 }
 
 UCTCrate::~UCTCrate() {
+  // Cards live in the arena; only their destructors are run here
   for(uint32_t i = 0; i < cards.size(); i++) {
-    if(cards[i] != 0) delete cards[i];
+    if(cards[i] != 0) cards[i]->~UCTCard();
   }
 }
 
@@ -32,6 +37,14 @@ bool UCTCrate::process() {
   return true;
 }
 
+bool UCTCrate::summarize() {
+  crateSummary = 0;
+  for(uint32_t i = 0; i < cards.size(); i++) {
+    if(cards[i] != 0) crateSummary += cards[i]->et();
+  }
+  return true;
+}
+
 bool UCTCrate::clearEvent() {
   crateSummary = 0;
   for(uint32_t i = 0; i < cards.size(); i++) {
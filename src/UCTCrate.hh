@@ -4,19 +4,20 @@
 #include <vector>
 
 #include "UCTGeometry.hh"
+#include "UCTArena.hh"
 
 class UCTCard;
 
 class UCTCrate {
 public:
 
-  UCTCrate(uint32_t crt);
+  UCTCrate(uint32_t crt, UCTArena& arena);
 
   virtual ~UCTCrate();
 
   // To set up event data before processing
 
-  const std::vector<UCTCard*>& getCards() {return cards;}
+  const UCTCardList& getCards() {return cards;}
   const UCTCard* getCard(uint32_t crd) const {return cards[crd];}
   const UCTCard* getCard(UCTTowerIndex t) const;
   const UCTCard* getCard(UCTRegionIndex r) const {
@@ -34,6 +35,14 @@ public:
 		    uint32_t hcalFB, uint32_t hcalET);
   bool process();
 
+  // To recompute the summary from already processed cards only
+
+  bool summarize();
+
+  // To restore a previously processed state
+
+  bool setState(uint32_t summary) {crateSummary = summary; return true;}
+
   // More access functions
 
   const uint32_t getCrate() const {return crate;}
@@ -61,7 +70,7 @@ private:
   // Owned crate level data 
 
   uint32_t crate;
-  std::vector<UCTCard*> cards;
+  UCTCardList cards;
   uint32_t crateSummary;
 
 };
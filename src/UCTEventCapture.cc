@@ -0,0 +1,198 @@
+#include <iostream>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTEventCapture.hh"
+
+#include "UCTLayer1.hh"
+#include "UCTCrate.hh"
+#include "UCTCard.hh"
+#include "UCTRegion.hh"
+#include "UCTTower.hh"
+#include "UCTBatch.hh"
+
+namespace {
+
+  void writeWords(std::fstream& file, const uint32_t* words, size_t n) {
+    if(n > 0) file.write((const char*) words, n * sizeof(uint32_t));
+  }
+
+  bool readWords(std::fstream& file, std::vector<uint32_t>& words, uint32_t n) {
+    words.resize(n);
+    if(n > 0) file.read((char*) &words[0], n * sizeof(uint32_t));
+    return file.good();
+  }
+
+  void unpackTPs(const std::vector<uint32_t>& tps, std::vector<int>& caloEta, std::vector<int>& caloPhi,
+		 std::vector<uint32_t>& et, std::vector<uint32_t>& flag) {
+    caloEta.resize(tps.size());
+    caloPhi.resize(tps.size());
+    et.resize(tps.size());
+    flag.resize(tps.size());
+    for(uint32_t i = 0; i < tps.size(); i++) {
+      caloEta[i] = UCTCaptureEvent::getCaloEta(tps[i]);
+      caloPhi[i] = UCTCaptureEvent::getCaloPhi(tps[i]);
+      et[i] = UCTCaptureEvent::getTPET(tps[i]);
+      flag[i] = UCTCaptureEvent::getTPFlag(tps[i]);
+    }
+  }
+
+}
+
+bool UCTEventCapture::openForWrite(const std::string& name) {
+  close();
+  file.open(name.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if(!file) {
+    std::cerr << "UCTEventCapture::openForWrite - Cannot open " << name << std::endl;
+    return false;
+  }
+  uint32_t header[2] = {captureMagic, captureVersion};
+  writeWords(file, header, 2);
+  fileName = name;
+  writing = true;
+  return file.good();
+}
+
+bool UCTEventCapture::openForRead(const std::string& name) {
+  close();
+  file.open(name.c_str(), std::ios::in | std::ios::binary);
+  if(!file) {
+    std::cerr << "UCTEventCapture::openForRead - Cannot open " << name << std::endl;
+    return false;
+  }
+  std::vector<uint32_t> header;
+  if(!readWords(file, header, 2) || header[0] != captureMagic || header[1] != captureVersion) {
+    std::cerr << "UCTEventCapture::openForRead - " << name << " is not a version " 
+	      << captureVersion << " capture file" << std::endl;
+    file.close();
+    return false;
+  }
+  fileName = name;
+  writing = false;
+  return true;
+}
+
+void UCTEventCapture::close() {
+  if(file.is_open()) file.close();
+  fileName.clear();
+  nEvents = 0;
+}
+
+bool UCTEventCapture::write(const UCTCaptureEvent& event) {
+  if(!writing || !file.is_open()) return false;
+  uint32_t header[9] = {event.run, event.lumi, 
+			(uint32_t) (event.event & 0xFFFFFFFF), (uint32_t) (event.event >> 32), (uint32_t) event.bx,
+			(uint32_t) event.ecalTPs.size(), (uint32_t) event.hcalTPs.size(),
+			(uint32_t) event.testTowers.size(), (uint32_t) event.emulTowers.size()};
+  writeWords(file, header, 9);
+  writeWords(file, event.ecalTPs.empty() ? 0 : &event.ecalTPs[0], event.ecalTPs.size());
+  writeWords(file, event.hcalTPs.empty() ? 0 : &event.hcalTPs[0], event.hcalTPs.size());
+  writeWords(file, event.testTowers.empty() ? 0 : &event.testTowers[0], event.testTowers.size());
+  writeWords(file, event.emulTowers.empty() ? 0 : &event.emulTowers[0], event.emulTowers.size());
+  // Flush so that the capture survives a crash of the job
+  file.flush();
+  if(!file.good()) {
+    std::cerr << "UCTEventCapture::write - Failed writing to " << fileName << std::endl;
+    return false;
+  }
+  nEvents++;
+  return true;
+}
+
+bool UCTEventCapture::read(UCTCaptureEvent& event) {
+  if(writing || !file.is_open()) return false;
+  event.clear();
+  std::vector<uint32_t> header;
+  if(!readWords(file, header, 9)) return false;
+  event.run = header[0];
+  event.lumi = header[1];
+  event.event = (((uint64_t) header[3]) << 32) | header[2];
+  event.bx = (int32_t) header[4];
+  for(uint32_t i = 5; i < 9; i++) {
+    if(header[i] > MaxCaptureWords) {
+      std::cerr << "UCTEventCapture::read - Bad record after " << nEvents << " events in " << fileName
+		<< "; " << header[i] << " words in a list" << std::endl;
+      return false;
+    }
+  }
+  if(!readWords(file, event.ecalTPs, header[5]) || !readWords(file, event.hcalTPs, header[6]) ||
+     !readWords(file, event.testTowers, header[7]) || !readWords(file, event.emulTowers, header[8])) {
+    std::cerr << "UCTEventCapture::read - Truncated record after " << nEvents << " events in " << fileName << std::endl;
+    return false;
+  }
+  nEvents++;
+  return true;
+}
+
+bool UCTEventCapture::replay(UCTLayer1& layer1, const UCTCaptureEvent& event, std::vector<uint32_t>& towers) {
+  towers.clear();
+  if(!layer1.clearEvent()) return false;
+  const std::vector<uint32_t>* tpLists[2] = {&event.ecalTPs, &event.hcalTPs};
+  std::vector<int> caloEta;
+  std::vector<int> caloPhi;
+  std::vector<uint32_t> et;
+  std::vector<uint32_t> flag;
+  for(uint32_t l = 0; l < 2; l++) {
+    const std::vector<uint32_t>& tps = *tpLists[l];
+    if(tps.empty()) continue;
+    unpackTPs(tps, caloEta, caloPhi, et, flag);
+    bool ok = (l == 0 ? 
+	       layer1.setECALData(&caloEta[0], &caloPhi[0], &et[0], &flag[0], tps.size()) :
+	       layer1.setHCALData(&caloEta[0], &caloPhi[0], &et[0], &flag[0], tps.size()));
+    if(!ok) return false;
+  }
+  if(!layer1.process()) return false;
+  const UCTCrateList& crates = layer1.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& regionTowers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < regionTowers.size(); twr++) {
+	  const UCTTower* t = regionTowers[twr];
+	  uint32_t word = UCTCaptureEvent::packTower(t->caloEta(), t->caloPhi(), t->et(), t->er(), t->miscBits());
+	  if(!UCTCaptureEvent::isEmptyTower(word)) towers.push_back(word);
+	}
+      }
+    }
+  }
+  return true;
+}
+
+bool UCTEventCapture::replay(UCTBatch& batch, const UCTCaptureEvent* events, uint32_t nEvents,
+			     std::vector<uint32_t>* towers) {
+  if(nEvents > BatchLanes) {
+    std::cerr << "UCTEventCapture::replay - At most " << BatchLanes << " events in a batch" << std::endl;
+    return false;
+  }
+  if(!batch.clearEvent()) return false;
+  std::vector<int> caloEta;
+  std::vector<int> caloPhi;
+  std::vector<uint32_t> et;
+  std::vector<uint32_t> flag;
+  for(uint32_t lane = 0; lane < nEvents; lane++) {
+    const std::vector<uint32_t>* tpLists[2] = {&events[lane].ecalTPs, &events[lane].hcalTPs};
+    for(uint32_t l = 0; l < 2; l++) {
+      const std::vector<uint32_t>& tps = *tpLists[l];
+      if(tps.empty()) continue;
+      unpackTPs(tps, caloEta, caloPhi, et, flag);
+      bool ok = (l == 0 ?
+		 batch.setECALData(lane, &caloEta[0], &caloPhi[0], &et[0], &flag[0], tps.size()) :
+		 batch.setHCALData(lane, &caloEta[0], &caloPhi[0], &et[0], &flag[0], tps.size()));
+      if(!ok) return false;
+    }
+  }
+  if(!batch.process()) return false;
+  for(uint32_t lane = 0; lane < nEvents; lane++) {
+    towers[lane].clear();
+    for(uint32_t twr = 0; twr < batch.getNTowers(); twr++) {
+      uint32_t data = batch.getTowerData(lane, twr);
+      if((data & stg2BitsMask) == EmptyTowerData) continue;
+      const UCTTowerIndex& t = batch.getTowerIndex(twr);
+      towers[lane].push_back(UCTCaptureEvent::packTower(t.first, t.second, (data & etMask), ((data & erMask) >> erShift),
+							((data & miscBitsMask) >> miscShift)));
+    }
+  }
+  return true;
+}
@@ -0,0 +1,126 @@
+#ifndef UCTEventCapture_hh
+#define UCTEventCapture_hh
+
+// UCT bad event capture
+// Compact binary sidecar file holding the complete inputs and the two
+// compared tower collections of selected (typically mismatching) events,
+// so that they can be replayed through UCTLayer1 stand-alone.
+// The file is a header (magic, version) followed by one record per event,
+// all host order 32-bit words:
+//   run, lumi, event (low word), event (high word), BX (signed),
+//   nECALTPs, nHCALTPs, nTestTowers, nEmulTowers,
+//   ECAL TP words, HCAL TP words, test tower words, emulator tower words
+// TP word:    caloEta (8 bits, signed), caloPhi (8 bits), ET (8 bits), flag (8 bits)
+// Tower word: caloEta (8 bits, signed), caloPhi (8 bits), 16-bit compressed tower data
+//             (ET 9 bits, ER 3 bits, misc 4 bits as in UCTTower::compressedData())
+// The towers are those of one crossing, BX relative to the triggered one.
+// TPs are those of the triggered crossing, so they are only stored with
+// BX 0 towers.
+// Empty towers (no ET and only the zero flag set) are not stored, and
+// missing towers are read back as empty.
+// Records with more than MaxCaptureWords TPs or towers of one kind are
+// rejected as corrupt when read.
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <stdint.h>
+
+#include "UCTTower.hh"
+
+class UCTLayer1;
+class UCTBatch;
+
+#define EmptyTowerData zeroFlagMask
+#define MaxCaptureWords (2 * (2 * MaxCaloEta + 1) * MaxCaloPhi)
+
+struct UCTCaptureEvent {
+
+  uint32_t run;
+  uint32_t lumi;
+  uint64_t event;
+  int32_t bx;
+
+  std::vector<uint32_t> ecalTPs;
+  std::vector<uint32_t> hcalTPs;
+  std::vector<uint32_t> testTowers;
+  std::vector<uint32_t> emulTowers;
+
+  void clear() {
+    run = 0;
+    lumi = 0;
+    event = 0;
+    bx = 0;
+    ecalTPs.clear();
+    hcalTPs.clear();
+    testTowers.clear();
+    emulTowers.clear();
+  }
+
+  static uint32_t packTP(int caloEta, int caloPhi, uint32_t et, uint32_t flag) {
+    return ((((uint32_t) caloEta & 0xFF) << 24) | (((uint32_t) caloPhi & 0xFF) << 16) | ((et & 0xFF) << 8) | (flag & 0xFF));
+  }
+  static uint32_t packTower(int caloEta, int caloPhi, uint32_t et, uint32_t er, uint32_t misc) {
+    return ((((uint32_t) caloEta & 0xFF) << 24) | (((uint32_t) caloPhi & 0xFF) << 16) | (et & 0x1FF) | ((er & 0x7) << 9) | ((misc & 0xF) << 12));
+  }
+
+  static int getCaloEta(uint32_t word) {return (int8_t) (word >> 24);}
+  static int getCaloPhi(uint32_t word) {return ((word >> 16) & 0xFF);}
+  static uint32_t getTPET(uint32_t word) {return ((word >> 8) & 0xFF);}
+  static uint32_t getTPFlag(uint32_t word) {return (word & 0xFF);}
+  static uint32_t getTowerData(uint32_t word) {return (word & 0xFFFF);}
+  static bool isEmptyTower(uint32_t word) {return (getTowerData(word) == EmptyTowerData);}
+
+};
+
+class UCTEventCapture {
+public:
+
+  UCTEventCapture() : writing(false), nEvents(0) {;}
+
+  virtual ~UCTEventCapture() {close();}
+
+  bool openForWrite(const std::string& name);
+  bool openForRead(const std::string& name);
+  void close();
+
+  bool write(const UCTCaptureEvent& event);
+
+  // Returns false at the end of the file or on a bad record
+
+  bool read(UCTCaptureEvent& event);
+
+  const uint32_t getNEvents() const {return nEvents;}
+
+  // Reprocesses the captured TPs and returns the non-empty towers in tower
+  // word format, in the UCTLayer1 hierarchy order
+
+  static bool replay(UCTLayer1& layer1, const UCTCaptureEvent& event, std::vector<uint32_t>& towers);
+
+  // The same for up to BatchLanes events at once through a UCTBatch of
+  // the configured UCTLayer1; towers[i] receives the towers of events[i]
+
+  static bool replay(UCTBatch& batch, const UCTCaptureEvent* events, uint32_t nEvents,
+		     std::vector<uint32_t>* towers);
+
+  static const uint32_t captureMagic = 0x55435443;
+  static const uint32_t captureVersion = 2;
+
+private:
+
+  // No copy constructor is needed
+
+  UCTEventCapture(const UCTEventCapture&);
+
+  // No equality operator is needed
+
+  const UCTEventCapture& operator=(const UCTEventCapture&);
+
+  std::fstream file;
+  std::string fileName;
+  bool writing;
+  uint32_t nEvents;
+
+};
+
+#endif
@@ -19,7 +19,7 @@ uint32_t UCTGeometry::getLinkNumber(bool negativeEta, uint32_t region,
     exit(1);
   }
   uint32_t linkNumber = 0xDEADBEEF;
-  if(region < MaxRegionNumber) {
+  if(region < NRegionsInCard) {
     if(iEta < NEtaInRegion / 2) {
       linkNumber = region * 2;
     }
@@ -28,15 +28,40 @@ uint32_t UCTGeometry::getLinkNumber(bool negativeEta, uint32_t region,
     }
   }
   else {
-    linkNumber = NRegionsInCard * 2 + iPhi;
+    linkNumber = NCentralLinksInSide + iPhi;
   }
 
   if(!negativeEta) {
-    linkNumber += NRegionsInCard * 2 + 2;
+    linkNumber += NLinksInSide;
   }
   return linkNumber;
 }
 
+uint32_t UCTGeometry::getChannelNumber(uint32_t region, uint32_t iEta, uint32_t iPhi) {
+  if(checkRegion(region)) {
+    std::cerr << "Invalid region number: region = " << region << std::endl;
+    exit(1);
+  }
+  if(checkEtaIndex(region, iEta)) {
+    std::cerr << "Invalid eta index: iEta = " << iEta << std::endl;
+    exit(1);
+  }
+  if(checkPhiIndex(region, iPhi)) {
+    std::cerr << "Invalid phi index: iPhi = " << iPhi << std::endl;
+    exit(1);
+  }
+  uint32_t channelNumber = 0xDEADBEEF;
+  if(region < NRegionsInCard) {
+    // Central links carry half a region: 2 eta x 4 phi towers
+    channelNumber = (iEta % (NEtaInRegion / 2)) * NPhiInRegion + iPhi;
+  }
+  else {
+    // HF links carry one phi slice of all HF regions of the side
+    channelNumber = (region - NRegionsInCard) * NHFEtaInRegion + iEta;
+  }
+  return channelNumber;
+}
+
 int UCTGeometry::getCaloEtaIndex(bool negativeSide, uint32_t region, uint32_t iEta) {
 
   if(checkRegion(region)) {
@@ -49,8 +74,8 @@ int UCTGeometry::getCaloEtaIndex(bool negativeSide, uint32_t region, uint32_t iE
   }
 
   int caloEtaIndex = region * NEtaInRegion + iEta + 1;
-  if(region > 6) {
-    caloEtaIndex = (region - 7) * NHFEtaInRegion + iEta + 30;
+  if(region >= CaloHFRegionStart) {
+    caloEtaIndex = (region - CaloHFRegionStart) * NHFEtaInRegion + iEta + HFEtaOffset + 1;
   }
 
   if(negativeSide) return -caloEtaIndex;
@@ -72,42 +97,18 @@ int UCTGeometry::getCaloPhiIndex(uint32_t crate, uint32_t card,
     std::cerr << "Invalid phi index: iPhi = " << iPhi << std::endl;
     exit(1);
   }
+  // Position of the crate in phi, and the first caloPhi of crate 0 in the
+  // segmentation of the region
+  uint32_t cratePosition = (NCrates - crate) % NCrates;
   int caloPhiIndex = 0xDEADBEEF;
   if(region < CaloHFRegionStart) {
-    if(crate == 0) {
-      caloPhiIndex = 11 + card * 4 + iPhi;
-    }
-    else if(crate == 1) {
-      caloPhiIndex = 59 + card * 4 + iPhi;
-    }
-    else if(crate == 2) {
-      caloPhiIndex = 35 + card * 4 + iPhi;
-    }
-    if(caloPhiIndex > 72) caloPhiIndex -= 72;
+    caloPhiIndex = ((FirstCaloPhiInCrate0 - 1) + (cratePosition * NCardsInCrate + card) * NPhiInRegion + iPhi) % MaxCaloPhi + 1;
   }
   else if(region < CaloVHFRegionStart) {
-    if(crate == 0) {
-      caloPhiIndex = 6 + card * 2 + iPhi;
-    }
-    else if(crate == 1) {
-      caloPhiIndex = 30 + card * 2 + iPhi;
-    }
-    else if(crate == 2) {
-      caloPhiIndex = 18 + card * 2 + iPhi;
-    }
-    if(caloPhiIndex > 36) caloPhiIndex -= 36;
+    caloPhiIndex = ((FirstCaloPhiInCrate0 + 1) / 2 - 1 + (cratePosition * NCardsInCrate + card) * NHFPhiInRegion + iPhi) % (MaxCaloPhiInHF) + 1;
   }
   else {
-    if(crate == 0) {
-      caloPhiIndex = 3 + card;
-    }
-    else if(crate == 1) {
-      caloPhiIndex = 15 + card;
-    }
-    else if(crate == 2) {
-      caloPhiIndex = 9 + card;
-    }
-    if(caloPhiIndex > 18) caloPhiIndex -= 18;
+    caloPhiIndex = ((FirstCaloPhiInCrate0 + 1) / 4 - 1 + cratePosition * NCardsInCrate + card) % (MaxCaloPhiInVHF) + 1;
   }
   return caloPhiIndex;
 }
@@ -121,22 +122,9 @@ uint32_t UCTGeometry::getUCTRegionPhiIndex(uint32_t crate, uint32_t card) {
     std::cerr << "Invalid card number: card = " << card << std::endl;
     exit(1);
   }
-  uint32_t uctRegionPhiIndex = 0xDEADBEEF;
-  if(crate == 0) {
-    uctRegionPhiIndex = 3 + card;
-  }
-  else if(crate == 1) {
-    if(card < 3) {
-      uctRegionPhiIndex = 15 + card;
-    }
-    else {
-      uctRegionPhiIndex = card - 3;
-    }
-  }
-  else if(crate == 2) {
-    uctRegionPhiIndex = 9 + card;
-  }
-  return uctRegionPhiIndex;
+  uint32_t cratePosition = (NCrates - crate) % NCrates;
+  uint32_t firstRegionPhiIndex = (FirstCaloPhiInCrate0 + 1) / NPhiInRegion;
+  return (firstRegionPhiIndex + cratePosition * NCardsInCrate + card) % (MaxUCTRegionsPhi);
 }
 
 uint32_t UCTGeometry::getCrate(int caloEta, int caloPhi) {
@@ -149,10 +137,10 @@ uint32_t UCTGeometry::getCrate(int caloEta, int caloPhi) {
   else if(region >= CaloHFRegionStart) {
     cPhi = caloPhi * 2;
   }
-  if(cPhi >= 11 && cPhi <= 34) crate = 0;
-  else if(cPhi >= 35 && cPhi <= 58) crate = 2;
-  else if(cPhi >= 59 && cPhi <= 72) crate = 1;
-  else if(cPhi >= 1 && cPhi <= 10) crate = 1;  
+  if(cPhi >= 1 && cPhi <= MaxCaloPhi) {
+    uint32_t offset = (cPhi + MaxCaloPhi - FirstCaloPhiInCrate0) % MaxCaloPhi;
+    crate = (NCrates - offset / (NCardsInCrate * NPhiInRegion)) % NCrates;
+  }
   return crate;
 }
 
@@ -167,18 +155,10 @@ uint32_t UCTGeometry::getCard(int caloEta, int caloPhi) {
   else if(region >= CaloHFRegionStart) {
     cPhi = caloPhi * 2;
   }
-  if(crate == 0) {
-    card = (cPhi - 11) / 4;
-  }
-  else if(crate == 2) {
-    card = (cPhi - 35) / 4;
-  }
-  else if(crate == 1 && cPhi > 58) {
-    card = (cPhi - 59) / 4;
+  if(crate < NCrates) {
+    uint32_t offset = (cPhi + MaxCaloPhi - FirstCaloPhiInCrate0) % MaxCaloPhi;
+    card = (offset % (NCardsInCrate * NPhiInRegion)) / NPhiInRegion;
   }
-  else if(crate == 1 && cPhi <= 10) {
-    card = (cPhi + 13) / 4;
-  }    
   return card;
 }
 
@@ -216,10 +196,10 @@ uint32_t UCTGeometry::getiPhi(int caloEta, int caloPhi) {
 uint32_t UCTGeometry::getNEta(uint32_t region) {
   uint32_t nEta = 0xDEADBEEF;
   if(region < CaloHFRegionStart) {
-    nEta = 4;
+    nEta = NEtaInRegion;
   }
   else {
-    nEta = 2;
+    nEta = NHFEtaInRegion;
   }
   return nEta;
 }
@@ -227,13 +207,13 @@ uint32_t UCTGeometry::getNEta(uint32_t region) {
 uint32_t UCTGeometry::getNPhi(uint32_t region) {
   uint32_t nPhi = 0xDEADBEEF;
   if(region < CaloHFRegionStart) {
-    nPhi = 4;
+    nPhi = NPhiInRegion;
   }
   else if(region < CaloVHFRegionStart) {
-    nPhi = 2;
+    nPhi = NHFPhiInRegion;
   }
   else {
-    nPhi = 1;
+    nPhi = NVHFPhiInCard;
   }
   return nPhi;
 }
@@ -32,19 +32,46 @@
 
 #include <utility>
 
+// Layout parameters
+// The default is the Run-2 layout.  Each parameter may be overridden at
+// compile time (e.g. -DNCardsInCrate=12) to build an alternative layout;
+// everything else, including table sizes and the crate phi placement,
+// is derived from these.
+
+#ifndef NCrates
 #define NCrates 3
+#endif
+#ifndef NCardsInCrate
 #define NCardsInCrate 6
+#endif
+#ifndef NRegionsInCard
 #define NRegionsInCard 7
+#endif
+#ifndef NEtaInRegion
 #define NEtaInRegion 4
+#endif
+#ifndef NPhiInRegion
 #define NPhiInRegion 4
+#endif
 #define NPhiInCard NPhiInRegion
 
 #define HFEtaOffset NRegionsInCard * NEtaInRegion + 1
+#ifndef NHFRegionsInCard
 #define NHFRegionsInCard 6
+#endif
+#ifndef NHFEtaInRegion
 #define NHFEtaInRegion 2
-#define NHFPhiInRegion 2
+#endif
+#define NHFPhiInRegion (NPhiInRegion / 2)
 #define NHFPhiInCard NHFPhiInRegion
-#define NVHFPhiInCard 1
+#define NVHFPhiInCard (NPhiInRegion / 4)
+
+// First central caloPhi of crate 0; the crates follow each other in phi
+// in the order 0, NCrates - 1, ..., 1
+
+#ifndef FirstCaloPhiInCrate0
+#define FirstCaloPhiInCrate0 11
+#endif
 
 #define NSides 2  // Positive and Negative Eta sides
 #define NEta NRegionsInCard * NEtaInRegion
@@ -58,13 +85,24 @@
 #define MaxEtaInRegion (NEtaInRegion - 1)
 #define MaxPhiInRegion (NPhiInRegion - 1)
 
-#define MaxCaloEta 41
-#define MaxCaloPhi 72
-#define CaloHFRegionStart 7
-#define CaloVHFRegionStart 12
+// The last HF region is the very forward one, with half the phi segmentation
+
+#define MaxCaloEta (HFEtaOffset + NHFEta)
+#define MaxCaloPhi (NCrates * NCardsInCrate * NPhiInRegion)
+#define CaloHFRegionStart NRegionsInCard
+#define CaloVHFRegionStart (NRegionsInCard + NHFRegionsInCard - 1)
 #define MaxCaloPhiInHF MaxCaloPhi/2
 #define MaxCaloPhiInVHF MaxCaloPhi/4
 
+// CTP7 link map: per side, two links for each central region (split in eta)
+// followed by one HF link for each HF phi index, which carries all HF eta
+// Channel is the tower position within the link
+
+#define NCentralLinksInSide (2 * NRegionsInCard)
+#define NLinksInSide (NCentralLinksInSide + NHFPhiInRegion)
+#define NLinksInCard (NSides * NLinksInSide)
+#define NChannelsInLink (NHFRegionsInCard * NHFEtaInRegion)
+
 #define MaxUCTRegionsPhi MaxCaloPhi / NPhiInRegion
 #define MaxUCTRegionsEta 2 * (NRegionsInCard + NHFRegionsInCard)
 
@@ -87,7 +125,7 @@ public:
   int getCaloPhiIndex(uint32_t crate, uint32_t card, uint32_t region, uint32_t iPhi);
 
   uint32_t getLinkNumber(bool negativeSide, uint32_t region, uint32_t iEta, uint32_t iPhi);
-  uint32_t getChannelNumber(bool negativeSide, uint32_t iEta, uint32_t iPhi);
+  uint32_t getChannelNumber(uint32_t region, uint32_t iEta, uint32_t iPhi);
 
   uint32_t getNCrates() {return NCrates;}
   uint32_t getNCards() {return NCardsInCrate;}
@@ -128,8 +166,8 @@ public:
   // In those cases, we loop over all regions.
 
   uint32_t getUCTRegionPhiIndex(int caloPhi) {
-    if(caloPhi < 71) return ((caloPhi + 1) / 4);
-    else return 17;
+    if(caloPhi < MaxCaloPhi - 1) return ((caloPhi + 1) / NPhiInRegion);
+    else return (MaxUCTRegionsPhi) - 1;
   }
   uint32_t getUCTRegionEtaIndex(int caloEta) {
     // Region index is same for all phi; so get for phi = 1
@@ -141,7 +179,7 @@ public:
   uint32_t getUCTRegionPhiIndex(uint32_t crate, uint32_t card);
 
   int getUCTRegionEtaIndex(bool negativeSide, uint32_t region) {
-    if(!checkRegion(region)) return 0xDEADBEEF;
+    if(checkRegion(region)) return 0xDEADBEEF;
     if(negativeSide) return -(region + 1);
     else return (region + 1);
   }
@@ -0,0 +1,170 @@
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "UCTGlobalSums.hh"
+
+#include "UCTLayer1.hh"
+#include "UCTCrate.hh"
+#include "UCTCard.hh"
+#include "UCTRegion.hh"
+#include "UCTTower.hh"
+
+#include "UCTGeometry.hh"
+
+namespace {
+
+  struct TrigTables {
+    TrigTables();
+    int32_t cosTower[MaxCaloPhi], sinTower[MaxCaloPhi];
+    int32_t cosHF[MaxCaloPhiInHF], sinHF[MaxCaloPhiInHF];
+    int32_t cosVHF[MaxCaloPhiInVHF], sinVHF[MaxCaloPhiInVHF];
+  };
+
+  void fillTable(int32_t* c, int32_t* s, uint32_t n, double offset) {
+    for(uint32_t i = 0; i < n; i++) {
+      double phi = (i + offset) * 2. * M_PI / n;
+      c[i] = (int32_t) lround(cos(phi) * (1 << GlobalSumTrigBits));
+      s[i] = (int32_t) lround(sin(phi) * (1 << GlobalSumTrigBits));
+    }
+  }
+
+}
+
+TrigTables::TrigTables() {
+  fillTable(cosTower, sinTower, MaxCaloPhi, 0.5);
+  fillTable(cosHF, sinHF, MaxCaloPhiInHF, 0.5);
+  fillTable(cosVHF, sinVHF, MaxCaloPhiInVHF, 0.);
+}
+
+const int32_t* UCTGlobalSums::getTable(uint32_t nPhiBins, bool sine) {
+  static const TrigTables tables;
+  if(nPhiBins == MaxCaloPhi) return (sine ? tables.sinTower : tables.cosTower);
+  if(nPhiBins == MaxCaloPhiInHF) return (sine ? tables.sinHF : tables.cosHF);
+  if(nPhiBins == MaxCaloPhiInVHF) return (sine ? tables.sinVHF : tables.cosVHF);
+  std::cerr << "UCTGlobalSums: Invalid number of phi bins " << nPhiBins << " -- bailing" << std::endl;
+  exit(1);
+}
+
+UCTGlobalSums::UCTGlobalSums(UCTLayer1& layer1, uint32_t towerHT, uint32_t regionHT) :
+  towerHTThreshold(towerHT),
+  regionHTThreshold(regionHT),
+  towerGrid(NTowerSumRings * MaxCaloPhi, 0),
+  towerRowPhiBins(NTowerSumRings, 0),
+  regionGrid(NRegionSumRings * MaxUCTRegionsPhi, 0),
+  rowET(MaxCaloPhi, 0) {
+  const UCTCrateList& crates = layer1.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	UCTRegion* region = regions[rgn];
+	UCTRegionIndex r = region->regionIndex();
+	uint32_t regionRing = (r.first < 0 ? (NRegionSumRings / 2 + r.first) : (NRegionSumRings / 2 + r.first - 1));
+	regionGrid[regionRing * MaxUCTRegionsPhi + r.second] = region;
+	uint32_t nPhiBins = MaxCaloPhi;
+	if(region->getRegion() >= CaloVHFRegionStart) nPhiBins = MaxCaloPhiInVHF;
+	else if(region->getRegion() >= CaloHFRegionStart) nPhiBins = MaxCaloPhiInHF;
+	const UCTTowerList& towers = region->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  uint32_t ring = towers[twr]->caloEta() + MaxCaloEta;
+	  uint32_t slot = towers[twr]->caloPhi() - 1;
+	  if(nPhiBins == MaxCaloPhiInVHF) slot = towers[twr]->caloPhi() % (MaxCaloPhiInVHF);
+	  towerGrid[ring * MaxCaloPhi + slot] = towers[twr];
+	  towerRowPhiBins[ring] = nPhiBins;
+	}
+      }
+    }
+  }
+}
+
+bool UCTGlobalSums::process() {
+
+  UCTEtSums zero = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  towerSums = zero;
+  for(uint32_t ring = 0; ring < NTowerSumRings; ring++) {
+    uint32_t nPhiBins = towerRowPhiBins[ring];
+    if(nPhiBins == 0) continue; // No towers at caloEta 0 and +/-29
+    const UCTTower* const* towers = &towerGrid[ring * MaxCaloPhi];
+    for(uint32_t i = 0; i < nPhiBins; i++) {
+      rowET[i] = towers[i]->et();
+    }
+    sumRow(&rowET[0], nPhiBins, towerHTThreshold, towerSums);
+  }
+  finish(towerSums);
+
+  regionSums = zero;
+  for(uint32_t ring = 0; ring < NRegionSumRings; ring++) {
+    const UCTRegion* const* regions = &regionGrid[ring * MaxUCTRegionsPhi];
+    for(uint32_t i = 0; i < MaxUCTRegionsPhi; i++) {
+      rowET[i] = regions[i]->et();
+    }
+    sumRow(&rowET[0], MaxUCTRegionsPhi, regionHTThreshold, regionSums);
+  }
+  finish(regionSums);
+
+  return true;
+
+}
+
+void UCTGlobalSums::sumRow(const uint32_t* et, uint32_t nPhiBins, uint32_t htThreshold, UCTEtSums& sums) {
+  // Straight loop over the row with 32-bit accumulators, which the
+  // compiler vectorizes; a row of 72 10-bit ETs times 2^10 fits easily
+  const int32_t* c = getTable(nPhiBins, false);
+  const int32_t* s = getTable(nPhiBins, true);
+  uint32_t ringET = 0;
+  uint32_t ringHT = 0;
+  int32_t x = 0;
+  int32_t y = 0;
+  int32_t hx = 0;
+  int32_t hy = 0;
+  for(uint32_t i = 0; i < nPhiBins; i++) {
+    int32_t e = et[i];
+    int32_t h = (et[i] > htThreshold ? e : 0);
+    ringET += e;
+    ringHT += h;
+    x += e * c[i];
+    y += e * s[i];
+    hx += h * c[i];
+    hy += h * s[i];
+  }
+  sums.et += ringET;
+  sums.ht += ringHT;
+  sums.metX -= x;
+  sums.metY -= y;
+  sums.mhtX -= hx;
+  sums.mhtY -= hy;
+}
+
+void UCTGlobalSums::finish(UCTEtSums& sums) {
+  // Magnitudes back in ET units, angles as the caloPhi bin holding them
+  const double scale = 1 << GlobalSumTrigBits;
+  const double binWidth = 2. * M_PI / MaxCaloPhi;
+  double met = sqrt((double) sums.metX * sums.metX + (double) sums.metY * sums.metY);
+  double mht = sqrt((double) sums.mhtX * sums.mhtX + (double) sums.mhtY * sums.mhtY);
+  sums.met = (uint32_t) (met / scale);
+  sums.mht = (uint32_t) (mht / scale);
+  double metPhi = atan2((double) sums.metY, (double) sums.metX);
+  double mhtPhi = atan2((double) sums.mhtY, (double) sums.mhtX);
+  if(metPhi < 0) metPhi += 2. * M_PI;
+  if(mhtPhi < 0) mhtPhi += 2. * M_PI;
+  sums.metPhi = ((uint32_t) (metPhi / binWidth)) % MaxCaloPhi + 1;
+  sums.mhtPhi = ((uint32_t) (mhtPhi / binWidth)) % MaxCaloPhi + 1;
+}
+
+void UCTGlobalSums::print() {
+  const UCTEtSums* sums[2] = {&towerSums, &regionSums};
+  const char* names[2] = {"Tower ", "Region"};
+  for(uint32_t i = 0; i < 2; i++) {
+    std::cout << "UCTGlobalSums: " << names[i] << " sums:"
+	      << " ET = " << std::dec << sums[i]->et
+	      << " HT = " << sums[i]->ht
+	      << " MET = " << sums[i]->met << " @ " << sums[i]->metPhi
+	      << " MHT = " << sums[i]->mht << " @ " << sums[i]->mhtPhi
+	      << std::endl;
+  }
+}
@@ -0,0 +1,104 @@
+#ifndef UCTGlobalSums_hh
+#define UCTGlobalSums_hh
+
+// UCT global energy sums
+// Scalar ET and HT and vector MET and MHT, computed from the processed
+// towers and, separately, from the processed regions.
+// MET is the negative vector sum of all deposits; HT and MHT only use
+// deposits above the HT threshold of their granularity.
+// Towers are gathered per caloEta ring and regions per region eta ring
+// into contiguous rows, and each row is reduced against fixed-point cos
+// and sin tables indexed by the phi bin of its segmentation:
+//   72 bins (central towers), 36 bins (HF), 18 bins (VHF and regions).
+// Slot s of a 72 or 36 bin row is centred at (s + 1/2) bin widths and
+// slot s of an 18 bin row at s bin widths, as VHF towers and regions have
+// card boundaries as edges; slot 0 of an 18 bin row is region phi 0.
+// Table values are scaled by 2^GlobalSumTrigBits.  Vector components are
+// kept at that scale; magnitudes are returned in ET units and angles as
+// a 72-bin caloPhi index (1-72).
+
+#include <vector>
+#include <stdint.h>
+
+#include "UCTGeometry.hh"
+
+class UCTLayer1;
+class UCTTower;
+class UCTRegion;
+
+#define GlobalSumTrigBits 10
+#define NTowerSumRings (2 * MaxCaloEta + 1)
+#define NRegionSumRings (MaxUCTRegionsEta)
+
+struct UCTEtSums {
+  uint32_t et;
+  uint32_t ht;
+  int64_t metX;
+  int64_t metY;
+  int64_t mhtX;
+  int64_t mhtY;
+  uint32_t met;
+  uint32_t metPhi;
+  uint32_t mht;
+  uint32_t mhtPhi;
+};
+
+class UCTGlobalSums {
+public:
+
+  UCTGlobalSums(UCTLayer1& layer1, uint32_t towerHTThreshold = 0, uint32_t regionHTThreshold = 0);
+
+  virtual ~UCTGlobalSums() {;}
+
+  // To be called after UCTLayer1::process()
+
+  bool process();
+
+  const UCTEtSums& getTowerSums() const {return towerSums;}
+  const UCTEtSums& getRegionSums() const {return regionSums;}
+
+  // Fixed-point cos and sin of the centre of a row slot
+  // nPhiBins must be MaxCaloPhi, MaxCaloPhiInHF or MaxCaloPhiInVHF (72, 36 or 18)
+
+  static int32_t getCos(uint32_t nPhiBins, uint32_t slot) {return getTable(nPhiBins, false)[slot];}
+  static int32_t getSin(uint32_t nPhiBins, uint32_t slot) {return getTable(nPhiBins, true)[slot];}
+
+  void print();
+
+private:
+
+  static const int32_t* getTable(uint32_t nPhiBins, bool sine);
+
+  // No default constructor is needed
+
+  UCTGlobalSums();
+
+  // No copy constructor is needed
+
+  UCTGlobalSums(const UCTGlobalSums&);
+
+  // No equality operator is needed
+
+  const UCTGlobalSums& operator=(const UCTGlobalSums&);
+
+  void sumRow(const uint32_t* et, uint32_t nPhiBins, uint32_t htThreshold, UCTEtSums& sums);
+
+  static void finish(UCTEtSums& sums);
+
+  uint32_t towerHTThreshold;
+  uint32_t regionHTThreshold;
+
+  // Rows are MaxCaloPhi wide; ring i uses the first rowPhiBins[i] entries
+
+  std::vector<const UCTTower*> towerGrid;
+  std::vector<uint32_t> towerRowPhiBins;
+  std::vector<const UCTRegion*> regionGrid;
+
+  std::vector<uint32_t> rowET;
+
+  UCTEtSums towerSums;
+  UCTEtSums regionSums;
+
+};
+
+#endif
@@ -2,6 +2,8 @@
 #include <iomanip>
 #include <stdlib.h>
 #include <stdint.h>
+#include <new>
+#include <algorithm>
 
 #include "UCTLayer1.hh"
 
@@ -11,21 +13,87 @@
 #include "UCTTower.hh"
 
 #include "UCTGeometry.hh"
+#include "UCTCalibrationLUT.hh"
+#include "UCTTowerSumTable.hh"
+#include "UCTChannelMask.hh"
+#include "UCTRegionVeto.hh"
+#include "UCTAllocationCounter.hh"
 
-UCTLayer1::UCTLayer1() : uctSummary(0) {
+UCTLayer1::UCTLayer1() :
+  arena(UCTArena::getLayer1PoolSizes()),
+  crates(UCTArenaAllocator<UCTCrate*>(arena)),
+  uctSummary(0),
+  calibrationLUT(0),
+  towerSumTable(0),
+  regionVeto(0),
+  maskedECALET(0),
+  maskedHCALET(0),
+  deltaMode(false),
+  deltaCheck(false),
+  deltaValid(false),
+  nChangedTowers(0) {
   UCTGeometry g;
+  crates.reserve(g.getNCrates());
   for(uint32_t crate = 0; crate < g.getNCrates(); crate++) {
-    crates.push_back(new UCTCrate(crate));
+    void* p = arena.allocate<UCTCrate>(UCTArena::CratePool);
+    crates.push_back(new (p) UCTCrate(crate, arena));
   }
+  // Tower look-up table for bulk TP setting
+  uint32_t tableSize = (2 * MaxCaloEta + 1) * (MaxCaloPhi + 1);
+  towerTable.assign(tableSize, 0);
+  cardTable.assign(tableSize, 0);
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  uint32_t i = (towers[twr]->caloEta() + MaxCaloEta) * (MaxCaloPhi + 1) + towers[twr]->caloPhi();
+	  towerTable[i] = towers[twr];
+	  cardTable[i] = crt * g.getNCards() + crd;
+	  allTowers.push_back(towers[twr]);
+	  towerRegions.push_back(allRegions.size());
+	  towerRings.push_back(towers[twr]->caloEta() + MaxCaloEta);
+	}
+	UCTRegionIndex r = regions[rgn]->regionIndex();
+	allRegions.push_back(regions[rgn]);
+	regionCards.push_back(allCards.size());
+	regionRings.push_back(r.first < 0 ? (MaxUCTRegionsEta / 2 + r.first) : (MaxUCTRegionsEta / 2 + r.first - 1));
+      }
+      allCards.push_back(cards[crd]);
+      cardCrates.push_back(crt);
+    }
+  }
+  cardOffsets.assign(g.getNCrates() * g.getNCards() + 1, 0);
+  towerRingET.assign(2 * MaxCaloEta + 1, 0);
+  regionRingET.assign(MaxUCTRegionsEta, 0);
+  deltaInputs.assign(allTowers.size(), 0);
+  regionChanged.assign(allRegions.size(), 0);
+  cardChanged.assign(allCards.size(), 0);
+  crateChanged.assign(crates.size(), 0);
+  regionVeto = new UCTRegionVeto(*this);
 }
 
 UCTLayer1::~UCTLayer1() {
+  if(towerSumTable != 0) delete towerSumTable;
+  delete regionVeto;
+  // Crates live in the arena; only their destructors are run here
+  // The arena releases all the memory in one go when it is destroyed
   for(uint32_t i = 0; i < crates.size(); i++) {
-    if(crates[i] != 0) delete crates[i];
+    if(crates[i] != 0) crates[i]->~UCTCrate();
   }
 }
 
 bool UCTLayer1::clearEvent() {
+  UCTAllocationStage stage(UCTAllocationCounter::InputStage);
+  if(deltaMode) {
+    // Keep the processed data for comparison with the next crossing
+    for(uint32_t i = 0; i < allTowers.size(); i++) {
+      allTowers[i]->setState(0, allTowers[i]->rawData());
+    }
+    return true;
+  }
   for(uint32_t i = 0; i < crates.size(); i++) {
     if(crates[i] != 0) crates[i]->clearEvent();
   }
@@ -33,8 +101,8 @@ bool UCTLayer1::clearEvent() {
 }
 
 const UCTRegion* UCTLayer1::getRegion(int regionEtaIndex, uint32_t regionPhiIndex) const {
-  if(regionEtaIndex == 0 || regionEtaIndex < -7 || regionEtaIndex > 7 ||
-     regionPhiIndex <= 0 || regionPhiIndex >= 19) {
+  if(regionEtaIndex == 0 || regionEtaIndex < -NRegionsInCard || regionEtaIndex > NRegionsInCard ||
+     regionPhiIndex <= 0 || regionPhiIndex > (MaxUCTRegionsPhi)) {
     return 0;
   }
   // Get (0,0) tower region information
@@ -60,15 +128,13 @@ const UCTTower* UCTLayer1::getTower(int caloEta, int caloPhi) const {
     std::cerr << "UCT::getTower - Negative caloPhi is unacceptable -- bailing" << std::endl;
     exit(1);
   }
-  UCTGeometry g;
-  UCTTowerIndex twr = UCTTowerIndex(caloEta, caloPhi);
-  const UCTRegionIndex rgn = g.getUCTRegionIndex(twr);
-  const UCTRegion* region = getRegion(rgn);
-  const UCTTower* tower = region->getTower(twr);
-  return tower;
+  // Direct look-up; caloPhi is in the segmentation of the tower (HF has 36 or 18 bins)
+  if(abs(caloEta) > MaxCaloEta || caloPhi > MaxCaloPhi) return 0;
+  return towerTable[(caloEta + MaxCaloEta) * (MaxCaloPhi + 1) + caloPhi];
 }
 
 bool UCTLayer1::setECALData(UCTTowerIndex t, bool ecalFG, uint32_t ecalET) {
+  UCTAllocationStage stage(UCTAllocationCounter::InputStage);
   uint32_t absCaloEta = abs(t.first);
   uint32_t absCaloPhi = abs(t.second);
   UCTGeometry g;
@@ -83,6 +149,7 @@ bool UCTLayer1::setECALData(UCTTowerIndex t, bool ecalFG, uint32_t ecalET) {
 }
 
 bool UCTLayer1::setHCALData(UCTTowerIndex t, uint32_t hcalFB, uint32_t hcalET) {
+  UCTAllocationStage stage(UCTAllocationCounter::InputStage);
   uint32_t absCaloEta = abs(t.first);
   uint32_t absCaloPhi = abs(t.second);
   UCTGeometry g;
@@ -104,15 +171,378 @@ bool UCTLayer1::setEventData(UCTTowerIndex t,
   return false;
 }
 
+bool UCTLayer1::groupTPs(const int* caloEta, const int* caloPhi, const uint32_t* et, uint32_t nTPs) {
+  if(nonZeroTPs.size() < nTPs) nonZeroTPs.resize(nTPs);
+  // Branch-free compaction of the non-zero TPs; the loop stays scalar, as
+  // each store depends on the count so far, but has no branches to mispredict
+  // on the zero ET TPs, which are most of them
+  uint32_t* nonZero = &nonZeroTPs[0];
+  uint32_t nNonZero = 0;
+  for(uint32_t i = 0; i < nTPs; i++) {
+    nonZero[nNonZero] = i;
+    nNonZero += (et[i] != 0);
+  }
+  // Count per card, then place the TPs card by card (counting sort)
+  std::fill(cardOffsets.begin(), cardOffsets.end(), 0);
+  for(uint32_t k = 0; k < nNonZero; k++) {
+    uint32_t i = nonZero[k];
+    uint32_t absCaloEta = abs(caloEta[i]);
+    if(absCaloEta > MaxCaloEta || caloPhi[i] < 1 || caloPhi[i] > MaxCaloPhi ||
+       towerTable[(caloEta[i] + MaxCaloEta) * (MaxCaloPhi + 1) + caloPhi[i]] == 0) {
+      std::cerr << "UCTLayer1::groupTPs - Invalid (caloEta, caloPhi) = (" << std::dec
+		<< caloEta[i] << ", " << caloPhi[i] << ")" << std::endl;
+      return false;
+    }
+    cardOffsets[cardTable[(caloEta[i] + MaxCaloEta) * (MaxCaloPhi + 1) + caloPhi[i]] + 1]++;
+  }
+  for(uint32_t c = 1; c < cardOffsets.size(); c++) {
+    cardOffsets[c] += cardOffsets[c - 1];
+  }
+  groupedTPs.resize(nNonZero);
+  for(uint32_t k = 0; k < nNonZero; k++) {
+    uint32_t i = nonZero[k];
+    uint32_t t = (caloEta[i] + MaxCaloEta) * (MaxCaloPhi + 1) + caloPhi[i];
+    groupedTPs[cardOffsets[cardTable[t]]++] = std::make_pair(i, towerTable[t]);
+  }
+  return true;
+}
+
+bool UCTLayer1::setECALData(const int* caloEta, const int* caloPhi, 
+			    const uint32_t* et, const uint32_t* flag, uint32_t nTPs) {
+  UCTAllocationStage stage(UCTAllocationCounter::InputStage);
+  if(!groupTPs(caloEta, caloPhi, et, nTPs)) return false;
+  for(uint32_t k = 0; k < groupedTPs.size(); k++) {
+    uint32_t i = groupedTPs[k].first;
+    if(!groupedTPs[k].second->setECALData((flag[i] != 0), et[i])) return false;
+  }
+  return true;
+}
+
+bool UCTLayer1::setHCALData(const int* caloEta, const int* caloPhi, 
+			    const uint32_t* et, const uint32_t* flag, uint32_t nTPs) {
+  UCTAllocationStage stage(UCTAllocationCounter::InputStage);
+  if(!groupTPs(caloEta, caloPhi, et, nTPs)) return false;
+  for(uint32_t k = 0; k < groupedTPs.size(); k++) {
+    uint32_t i = groupedTPs[k].first;
+    if(!groupedTPs[k].second->setHCALData(et[i], flag[i])) return false;
+  }
+  return true;
+}
+
 bool UCTLayer1::process() {
+  UCTAllocationStage stage(UCTAllocationCounter::MaskStage);
+  sumMaskedET();
+  if(deltaMode) return processDelta();
+  return processAll();
+}
+
+void UCTLayer1::sumMaskedET() {
+  maskedECALET = 0;
+  maskedHCALET = 0;
+  for(uint32_t i = 0; i < maskedTowers.size(); i++) {
+    maskedECALET += maskedTowers[i]->getMaskedEcalET();
+    maskedHCALET += maskedTowers[i]->getMaskedHcalET();
+  }
+}
+
+bool UCTLayer1::processAll() {
+  // Same as processing the crates, but with the region veto bits decided
+  // for all central regions at once; the towers, regions and card sums go
+  // through the region shape kernels of the cards
+  UCTAllocationStage stage(UCTAllocationCounter::CardStage);
+  for(uint32_t i = 0; i < allCards.size(); i++) {
+    if(!allCards[i]->process(false)) return false;
+  }
+  stage.set(UCTAllocationCounter::VetoStage);
+  if(!regionVeto->process(UCTRegion::getDefaultThresholds())) return false;
+  stage.set(UCTAllocationCounter::CrateStage);
   uctSummary = 0;
   for(uint32_t i = 0; i < crates.size(); i++) {
-    if(crates[i] != 0) {
-      crates[i]->process();
+    crates[i]->summarize();
+    uctSummary += crates[i]->et();
+  }
+
+  stage.set(UCTAllocationCounter::RingStage);
+  sumRings();
+
+  if(deltaMode) {
+    for(uint32_t i = 0; i < allTowers.size(); i++) {
+      deltaInputs[i] = allTowers[i]->inputData();
+    }
+    deltaValid = true;
+  }
+
+  stage.set(UCTAllocationCounter::TableStage);
+  if(towerSumTable != 0) return towerSumTable->build();
+
+  return true;
+}
+
+bool UCTLayer1::processDelta() {
+  // Start from a full processing
+  if(!deltaValid) return processAll();
+
+  UCTAllocationStage stage(UCTAllocationCounter::TowerStage);
+  nChangedTowers = 0;
+  for(uint32_t i = 0; i < allTowers.size(); i++) {
+    UCTTower* tower = allTowers[i];
+    uint32_t input = tower->inputData();
+    if(input == deltaInputs[i]) continue;
+    deltaInputs[i] = input;
+    uint32_t oldET = tower->et();
+    if(!tower->process()) return false;
+    towerRingET[towerRings[i]] += tower->et() - oldET;
+    regionChanged[towerRegions[i]] = 1;
+    nChangedTowers++;
+  }
+
+  if(nChangedTowers != 0) {
+    stage.set(UCTAllocationCounter::RegionStage);
+    for(uint32_t i = 0; i < allRegions.size(); i++) {
+      if(!regionChanged[i]) continue;
+      regionChanged[i] = 0;
+      uint32_t oldET = allRegions[i]->et();
+      if(!allRegions[i]->summarize()) return false;
+      regionRingET[regionRings[i]] += allRegions[i]->et() - oldET;
+      cardChanged[regionCards[i]] = 1;
+    }
+    stage.set(UCTAllocationCounter::CardStage);
+    for(uint32_t i = 0; i < allCards.size(); i++) {
+      if(!cardChanged[i]) continue;
+      cardChanged[i] = 0;
+      allCards[i]->summarize();
+      crateChanged[cardCrates[i]] = 1;
+    }
+    stage.set(UCTAllocationCounter::CrateStage);
+    uctSummary = 0;
+    for(uint32_t i = 0; i < crates.size(); i++) {
+      if(crateChanged[i]) crates[i]->summarize();
+      crateChanged[i] = 0;
       uctSummary += crates[i]->et();
     }
+    stage.set(UCTAllocationCounter::TableStage);
+    if(towerSumTable != 0 && !towerSumTable->build()) return false;
   }
 
+  if(deltaCheck) {
+    stage.set(UCTAllocationCounter::CheckStage);
+    std::vector<uint8_t> deltaState(snapshotSize());
+    std::vector<uint8_t> fullState(deltaState.size());
+    snapshot(&deltaState[0], deltaState.size());
+    std::vector<uint32_t> deltaTowerRingET(towerRingET);
+    std::vector<uint32_t> deltaRegionRingET(regionRingET);
+    if(!processAll()) return false;
+    snapshot(&fullState[0], fullState.size());
+    if(deltaState != fullState || deltaTowerRingET != towerRingET || deltaRegionRingET != regionRingET) {
+      std::cerr << "UCTLayer1::process - Delta processing differs from full processing" << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool UCTLayer1::setDeltaMode(bool enable, bool check) {
+  deltaMode = enable;
+  deltaCheck = check;
+  deltaValid = false;
+  return true;
+}
+
+void UCTLayer1::sumRings() {
+  std::fill(towerRingET.begin(), towerRingET.end(), 0);
+  for(uint32_t i = 0; i < allTowers.size(); i++) {
+    towerRingET[towerRings[i]] += allTowers[i]->et();
+  }
+  std::fill(regionRingET.begin(), regionRingET.end(), 0);
+  for(uint32_t i = 0; i < allRegions.size(); i++) {
+    regionRingET[regionRings[i]] += allRegions[i]->et();
+  }
+}
+
+bool UCTLayer1::enableTowerSumTable(bool enable) {
+  if(enable && towerSumTable == 0) {
+    towerSumTable = new UCTTowerSumTable(*this);
+    return towerSumTable->build();
+  }
+  if(!enable && towerSumTable != 0) {
+    delete towerSumTable;
+    towerSumTable = 0;
+  }
+  return true;
+}
+
+bool UCTLayer1::setCalibrationLUT(const UCTCalibrationLUT* lut) {
+  if(lut != 0 && !lut->isLoaded()) {
+    std::cerr << "UCTLayer1::setCalibrationLUT - LUT set is not loaded" << std::endl;
+    return false;
+  }
+  calibrationLUT = lut;
+  // The towers have to be reprocessed with the new tables
+  deltaValid = false;
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  UCTTower* tower = towers[twr];
+	  if(lut == 0) {
+	    tower->setCalibrationLUTs(0, 0);
+	  }
+	  else {
+	    int caloEta = tower->caloEta();
+	    int caloPhi = tower->caloPhi();
+	    // HF towers have no ECAL input
+	    const uint8_t* ecalLUT = 0;
+	    if(tower->getRegion() < NRegionsInCard) ecalLUT = lut->getECALLUT(caloEta, caloPhi);
+	    tower->setCalibrationLUTs(ecalLUT, lut->getHCALLUT(caloEta, caloPhi));
+	  }
+	}
+      }
+    }
+  }
+  return true;
+}
+
+bool UCTLayer1::setChannelMask(const UCTChannelMask* mask) {
+  // The towers have to be reprocessed with the new masks
+  deltaValid = false;
+  maskedTowers.clear();
+  for(uint32_t i = 0; i < allTowers.size(); i++) {
+    UCTTower* tower = allTowers[i];
+    if(mask == 0) {
+      tower->setChannelMask(false, false);
+    }
+    else {
+      int caloEta = tower->caloEta();
+      int caloPhi = tower->caloPhi();
+      tower->setChannelMask(mask->isECALMasked(caloEta, caloPhi), mask->isHCALMasked(caloEta, caloPhi));
+    }
+    if(tower->isECALMasked() || tower->isHCALMasked()) maskedTowers.push_back(tower);
+  }
+  return true;
+}
+
+UCTLayer1* UCTLayer1::clone() const {
+  UCTLayer1* copy = new UCTLayer1;
+  copy->setCalibrationLUT(calibrationLUT);
+  bool copyTable = (towerSumTable != 0);
+  copy->uctSummary = uctSummary;
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    const UCTCardList& copyCards = copy->crates[crt]->getCards();
+    copy->crates[crt]->setState(crates[crt]->getCrateSummary());
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      const UCTRegionList& copyRegions = copyCards[crd]->getRegions();
+      copyCards[crd]->setState(cards[crd]->et());
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	const UCTTowerList& copyTowers = copyRegions[rgn]->getTowers();
+	copyRegions[rgn]->setState(regions[rgn]->rawData());
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  copyTowers[twr]->setState(towers[twr]->inputData(), towers[twr]->rawData());
+	}
+      }
+    }
+  }
+  // Channel masks are carried over tower by tower
+  for(uint32_t i = 0; i < maskedTowers.size(); i++) {
+    const UCTTower* t = maskedTowers[i];
+    UCTTower* copyTower = copy->towerTable[(t->caloEta() + MaxCaloEta) * (MaxCaloPhi + 1) + t->caloPhi()];
+    copyTower->setChannelMask(t->isECALMasked(), t->isHCALMasked());
+    copy->maskedTowers.push_back(copyTower);
+  }
+  copy->maskedECALET = maskedECALET;
+  copy->maskedHCALET = maskedHCALET;
+  copy->sumRings();
+  copy->enableTowerSumTable(copyTable);
+  return copy;
+}
+
+size_t UCTLayer1::snapshotSize() const {
+  size_t nWords = snapshotHeaderWords + crates.size();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    nWords += cards.size();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      nWords += regions.size();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	nWords += 2 * regions[rgn]->getTowers().size();
+      }
+    }
+  }
+  return nWords * sizeof(uint32_t);
+}
+
+size_t UCTLayer1::snapshot(uint8_t* buffer, size_t size) const {
+  size_t nBytes = snapshotSize();
+  if(buffer == 0 || size < nBytes) {
+    std::cerr << "UCTLayer1::snapshot - Buffer of " << size << " bytes is too small; "
+	      << nBytes << " needed" << std::endl;
+    return 0;
+  }
+  uint32_t* word = (uint32_t*) buffer;
+  *word++ = snapshotMagic;
+  *word++ = snapshotVersion;
+  *word++ = nBytes;
+  *word++ = uctSummary;
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    *word++ = crates[crt]->getCrateSummary();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      *word++ = cards[crd]->et();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	*word++ = regions[rgn]->rawData();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  *word++ = towers[twr]->inputData();
+	  *word++ = towers[twr]->rawData();
+	}
+      }
+    }
+  }
+  return nBytes;
+}
+
+bool UCTLayer1::restore(const uint8_t* buffer, size_t size) {
+  size_t nBytes = snapshotSize();
+  if(buffer == 0 || size < nBytes) {
+    std::cerr << "UCTLayer1::restore - Snapshot of " << size << " bytes is too small; "
+	      << nBytes << " needed" << std::endl;
+    return false;
+  }
+  const uint32_t* word = (const uint32_t*) buffer;
+  if(word[0] != snapshotMagic || word[1] != snapshotVersion || word[2] != nBytes) {
+    std::cerr << "UCTLayer1::restore - Snapshot header is not recognized" << std::endl;
+    return false;
+  }
+  word += 3;
+  uctSummary = *word++;
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    crates[crt]->setState(*word++);
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      cards[crd]->setState(*word++);
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	regions[rgn]->setState(*word++);
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  uint32_t input = *word++;
+	  towers[twr]->setState(input, *word++);
+	}
+      }
+    }
+  }
+  sumRings();
+  sumMaskedET();
+  deltaValid = false;
+  if(towerSumTable != 0) return towerSumTable->build();
   return true;
 }
 
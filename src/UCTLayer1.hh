@@ -6,8 +6,13 @@
 class UCTCrate;
 class UCTRegion;
 class UCTTower;
+class UCTCalibrationLUT;
+class UCTTowerSumTable;
+class UCTChannelMask;
+class UCTRegionVeto;
 
 #include "UCTGeometry.hh"
+#include "UCTArena.hh"
 
 class UCTLayer1 {
 public:
@@ -18,7 +23,7 @@ public:
 
   // To access Layer1 information
 
-  std::vector<UCTCrate*>& getCrates() {return crates;}
+  const UCTCrateList& getCrates() {return crates;}
   const UCTRegion* getRegion(UCTRegionIndex r) const {return getRegion(r.first, r.second);}
   const UCTTower* getTower(UCTTowerIndex t) const {return getTower(t.first, t.second);}
 
@@ -31,14 +36,95 @@ public:
   bool setEventData(UCTTowerIndex t,
 		    bool ecalFG, uint32_t ecalET, 
 		    uint32_t hcalFB, uint32_t hcalET);
+  // Bulk setting of (caloEta, caloPhi, et, flag) arrays of TPs
+  // flag is the ECAL fine grain bit or the HCAL feature bits
+  // Zero ET TPs are dropped and the rest are grouped by card before
+  // they are written to the towers through a (caloEta, caloPhi) table
+  bool setECALData(const int* caloEta, const int* caloPhi, 
+		   const uint32_t* et, const uint32_t* flag, uint32_t nTPs);
+  bool setHCALData(const int* caloEta, const int* caloPhi, 
+		   const uint32_t* et, const uint32_t* flag, uint32_t nTPs);
   // To process event
   bool process();
 
+  // Delta processing for streams of crossings
+  // While enabled, process() only reprocesses the towers whose inputs
+  // changed since the last processed crossing, and updates the summaries
+  // of the regions, cards and crates above them and the eta ring sums;
+  // clearEvent() then only clears the tower inputs.
+  // With the check on, every delta result is compared with a full
+  // reprocessing of the same crossing, and process() fails on a mismatch.
+
+  bool setDeltaMode(bool enable, bool check = false);
+  const bool getDeltaMode() const {return deltaMode;}
+  const uint32_t getNChangedTowers() const {return nChangedTowers;}
+
   // More access functions
 
   uint32_t getSummary() {return uctSummary;}
   uint32_t et() {return uctSummary;}
 
+  // ET per eta ring, filled by process()
+  // Tower rings are indexed by caloEta (-41 to 41; 0 and +/-29 are empty)
+  // and region rings by region eta index (-13 to 13 without 0)
+
+  uint32_t getTowerRingET(int caloEta) const {
+    return ((caloEta < -MaxCaloEta || caloEta > MaxCaloEta) ? 0 : towerRingET[caloEta + MaxCaloEta]);
+  }
+  uint32_t getRegionRingET(int regionEta) const {
+    if(regionEta == 0 || regionEta < -MaxUCTRegionsEta / 2 || regionEta > MaxUCTRegionsEta / 2) return 0;
+    return regionRingET[regionEta < 0 ? (MaxUCTRegionsEta / 2 + regionEta) : (MaxUCTRegionsEta / 2 + regionEta - 1)];
+  }
+
+  // Per-tower calibration; the LUT set is not owned and must outlive its use
+  // Pass a null pointer to run uncalibrated
+
+  bool setCalibrationLUT(const UCTCalibrationLUT* lut);
+  const UCTCalibrationLUT* getCalibrationLUT() const {return calibrationLUT;}
+
+  // Dead/hot channel masks; the mask table is not owned and is only read
+  // here, so it may be changed or released afterwards
+  // Pass a null pointer to unmask all channels
+
+  bool setChannelMask(const UCTChannelMask* mask);
+  const uint32_t getNMaskedTowers() const {return maskedTowers.size();}
+
+  // Input ET of the masked channels in the last processed event
+
+  const uint32_t getMaskedECALET() const {return maskedECALET;}
+  const uint32_t getMaskedHCALET() const {return maskedHCALET;}
+
+  // Optional summed-area table of tower ET, rebuilt at the end of each
+  // process() while enabled; null when disabled
+
+  bool enableTowerSumTable(bool enable);
+  const UCTTowerSumTable* getTowerSumTable() const {return towerSumTable;}
+
+  // Cloning and snapshot/restore of the full event state
+  // The snapshot holds the inputs and packed outputs of all towers and the
+  // summaries of all regions, cards and crates as host order 32-bit words
+  // Restore into any UCTLayer1 is bit-exact without reprocessing
+
+  UCTLayer1* clone() const;
+
+  size_t snapshotSize() const;
+  size_t snapshot(uint8_t* buffer, size_t size) const;
+  bool restore(const uint8_t* buffer, size_t size);
+
+  // Snapshot header: magic, version, size in bytes, uctSummary
+
+  static const uint32_t snapshotMagic = 0x55435431;
+  static const uint32_t snapshotVersion = 1;
+  static const uint32_t snapshotHeaderWords = 4;
+
+  // All towers in hierarchy order (crate, card, region, tower)
+
+  const std::vector<UCTTower*>& getAllTowers() const {return allTowers;}
+
+  // All emulator objects are held in one arena
+
+  const UCTArena& getArena() const {return arena;}
+
   void print();
 
 private:
@@ -56,12 +142,70 @@ private:
   const UCTRegion* getRegion(int regionEtaIndex, uint32_t regionPhiIndex) const;
   const UCTTower* getTower(int caloEtaIndex, int caloPhiIndex) const;
 
+  void sumRings();
+  void sumMaskedET();
+
+  bool processAll();
+  bool processDelta();
+
+  bool groupTPs(const int* caloEta, const int* caloPhi, const uint32_t* et, uint32_t nTPs);
+
   //Private data
 
-  std::vector<UCTCrate*> crates;
+  // The arena must be declared first so that it outlives the objects in it
+
+  UCTArena arena;
+
+  UCTCrateList crates;
 
   uint32_t uctSummary;
 
+  const UCTCalibrationLUT* calibrationLUT;
+
+  UCTTowerSumTable* towerSumTable;
+
+  // Veto bits of all central regions are decided together
+
+  UCTRegionVeto* regionVeto;
+
+  std::vector<UCTTower*> maskedTowers;
+  uint32_t maskedECALET;
+  uint32_t maskedHCALET;
+
+  // All towers, regions and cards in hierarchy order, with the index of
+  // their parent in the list above, and the eta ring of towers and regions
+
+  std::vector<UCTTower*> allTowers;
+  std::vector<uint32_t> towerRegions;
+  std::vector<uint32_t> towerRings;
+  std::vector<UCTRegion*> allRegions;
+  std::vector<uint32_t> regionCards;
+  std::vector<uint32_t> regionRings;
+  std::vector<UCTCard*> allCards;
+  std::vector<uint32_t> cardCrates;
+  std::vector<uint32_t> towerRingET;
+  std::vector<uint32_t> regionRingET;
+
+  // Delta processing state: tower inputs of the last processed crossing
+  // and the objects to be summarized again
+
+  bool deltaMode;
+  bool deltaCheck;
+  bool deltaValid;
+  uint32_t nChangedTowers;
+  std::vector<uint32_t> deltaInputs;
+  std::vector<uint8_t> regionChanged;
+  std::vector<uint8_t> cardChanged;
+  std::vector<uint8_t> crateChanged;
+
+  // Direct (caloEta, caloPhi) to tower look-up and bulk TP scratch space
+
+  std::vector<UCTTower*> towerTable;
+  std::vector<uint32_t> cardTable;
+  std::vector<uint32_t> nonZeroTPs;
+  std::vector<uint32_t> cardOffsets;
+  std::vector<std::pair<uint32_t, UCTTower*> > groupedTPs;
+
 };
 
 #endif
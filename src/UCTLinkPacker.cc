@@ -0,0 +1,65 @@
+#include <iostream>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "UCTLinkPacker.hh"
+
+#include "UCTLayer1.hh"
+#include "UCTCrate.hh"
+#include "UCTCard.hh"
+#include "UCTRegion.hh"
+#include "UCTTower.hh"
+
+#include "UCTGeometry.hh"
+
+UCTLinkPacker::UCTLinkPacker(UCTLayer1& layer1) :
+  buffer(NCrates * NCardsInCrate * NWordsInCard, 0) {
+  UCTGeometry g;
+  const UCTCrateList& crates = layer1.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      uint32_t cardOffset = (crt * NCardsInCrate + crd) * NWordsInCard;
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTRegion* region = regions[rgn];
+	uint32_t side = (region->isNegativeEta() ? 0 : 1);
+	uint32_t regionOffset = cardOffset + NTowerWordsInCard +
+	  side * (NRegionsInCard + NHFRegionsInCard) + region->getRegion();
+	regionWords.push_back(std::make_pair(regionOffset, region));
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  const UCTTower* tower = towers[twr];
+	  uint32_t link = g.getLinkNumber(tower->isNegativeEta(), tower->getRegion(),
+					  tower->getiEta(), tower->getiPhi());
+	  uint32_t channel = g.getChannelNumber(tower->getRegion(),
+						tower->getiEta(), tower->getiPhi());
+	  if(link >= NLinksInCard || channel >= NChannelsInLink) {
+	    std::cerr << "UCTLinkPacker: Invalid (link, channel) = (" << link << ", " << channel
+		      << ") -- bailing" << std::endl;
+	    exit(1);
+	  }
+	  towerWords.push_back(std::make_pair(cardOffset + link * NChannelsInLink + channel, tower));
+	}
+      }
+    }
+  }
+}
+
+bool UCTLinkPacker::pack() {
+  // Unused channels are never written, so they remain zero
+  uint16_t* words = &buffer[0];
+  for(uint32_t i = 0; i < towerWords.size(); i++) {
+    words[towerWords[i].first] = towerWords[i].second->compressedData();
+  }
+  for(uint32_t i = 0; i < regionWords.size(); i++) {
+    words[regionWords[i].first] = (uint16_t) regionWords[i].second->rawData();
+  }
+  return true;
+}
+
+bool UCTLinkPacker::compare(const uint16_t* other, size_t otherSize) const {
+  if(other == 0 || otherSize != buffer.size()) return false;
+  return (memcmp(&buffer[0], other, sizeInBytes()) == 0);
+}
@@ -0,0 +1,87 @@
+#ifndef UCTLinkPacker_hh
+#define UCTLinkPacker_hh
+
+// UCT CTP7 output link packer
+// Packs the 16-bit tower words and region summaries of all cards into one
+// preallocated contiguous buffer in link order, following the link and
+// channel map of UCTGeometry, so that it can be compared with spy captures
+// using memcmp.
+//
+// Per card the buffer holds:
+//   NLinksInCard links of NChannelsInLink tower words (unused channels zero)
+//   NSides summary links of one region word per region
+// Cards follow one another in (crate, card) order.
+
+#include <vector>
+#include <utility>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "UCTGeometry.hh"
+
+class UCTLayer1;
+class UCTRegion;
+class UCTTower;
+
+#define NTowerWordsInCard (NLinksInCard * NChannelsInLink)
+#define NRegionWordsInCard (NSides * (NRegionsInCard + NHFRegionsInCard))
+#define NWordsInCard (NTowerWordsInCard + NRegionWordsInCard)
+
+class UCTLinkPacker {
+public:
+
+  UCTLinkPacker(UCTLayer1& layer1);
+
+  virtual ~UCTLinkPacker() {;}
+
+  // To be called after UCTLayer1::process()
+
+  bool pack();
+
+  // Packed data access
+
+  const uint16_t* getBuffer() const {return &buffer[0];}
+  const size_t size() const {return buffer.size();}
+  const size_t sizeInBytes() const {return buffer.size() * sizeof(uint16_t);}
+
+  const uint16_t* getCardBuffer(uint32_t crate, uint32_t card) const {
+    return &buffer[(crate * NCardsInCrate + card) * NWordsInCard];
+  }
+
+  const uint16_t* getLink(uint32_t crate, uint32_t card, uint32_t link) const {
+    return getCardBuffer(crate, card) + link * NChannelsInLink;
+  }
+
+  const uint16_t* getRegionLink(uint32_t crate, uint32_t card, bool negativeEta) const {
+    uint32_t side = (negativeEta ? 0 : 1);
+    return getCardBuffer(crate, card) + NTowerWordsInCard + side * (NRegionsInCard + NHFRegionsInCard);
+  }
+
+  // Comparison with a buffer of the same layout, e.g. from a spy capture
+
+  bool compare(const uint16_t* other, size_t otherSize) const;
+
+private:
+
+  // No default constructor is needed
+
+  UCTLinkPacker();
+
+  // No copy constructor is needed
+
+  UCTLinkPacker(const UCTLinkPacker&);
+
+  // No equality operator is needed
+
+  const UCTLinkPacker& operator=(const UCTLinkPacker&);
+
+  // Precomputed word offset for every tower and region
+
+  std::vector<std::pair<uint32_t, const UCTTower*> > towerWords;
+  std::vector<std::pair<uint32_t, const UCTRegion*> > regionWords;
+
+  std::vector<uint16_t> buffer;
+
+};
+
+#endif
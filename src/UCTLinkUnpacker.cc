@@ -0,0 +1,75 @@
+#include <iostream>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTLinkUnpacker.hh"
+
+#include "UCTLayer1.hh"
+#include "UCTCrate.hh"
+#include "UCTCard.hh"
+#include "UCTRegion.hh"
+#include "UCTTower.hh"
+
+#include "UCTGeometry.hh"
+
+UCTLinkUnpacker::UCTLinkUnpacker(UCTLayer1& layer1) {
+  UCTGeometry g;
+  const UCTCrateList& crates = layer1.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      cardStart.push_back(linkChannels.size());
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  UCTTower* tower = towers[twr];
+	  uint32_t link = g.getLinkNumber(tower->isNegativeEta(), tower->getRegion(),
+					  tower->getiEta(), tower->getiPhi());
+	  uint32_t channel = g.getChannelNumber(tower->getRegion(),
+						tower->getiEta(), tower->getiPhi());
+	  if(link >= NLinksInCard || channel >= NChannelsInLink) {
+	    std::cerr << "UCTLinkUnpacker: Invalid (link, channel) = (" << link << ", " << channel
+		      << ") -- bailing" << std::endl;
+	    exit(1);
+	  }
+	  LinkChannel lc;
+	  lc.word = link * NChannelsInLink + channel;
+	  lc.tower = tower;
+	  linkChannels.push_back(lc);
+	}
+      }
+    }
+  }
+  cardStart.push_back(linkChannels.size());
+}
+
+bool UCTLinkUnpacker::unpack(uint32_t crate, uint32_t card, 
+			     const uint16_t* ecalLinks, const uint16_t* hcalLinks) {
+  if(crate >= NCrates || card >= NCardsInCrate) {
+    std::cerr << "UCTLinkUnpacker: Incorrect (crate, card) = (" << crate << ", " << card << ")" << std::endl;
+    return false;
+  }
+  uint32_t i = crate * NCardsInCrate + card;
+  const LinkChannel* lc = &linkChannels[cardStart[i]];
+  const LinkChannel* end = &linkChannels[0] + cardStart[i + 1];
+  for(; lc != end; ++lc) {
+    lc->tower->setLinkData(ecalLinks[lc->word], hcalLinks[lc->word]);
+  }
+  return true;
+}
+
+bool UCTLinkUnpacker::unpack(const uint16_t* inputLinks, size_t size) {
+  if(inputLinks == 0 || size < UCTLinkUnpacker::size()) {
+    std::cerr << "UCTLinkUnpacker: Input of " << size << " words is too small; "
+	      << UCTLinkUnpacker::size() << " needed" << std::endl;
+    return false;
+  }
+  for(uint32_t crt = 0; crt < NCrates; crt++) {
+    for(uint32_t crd = 0; crd < NCardsInCrate; crd++) {
+      const uint16_t* cardLinks = inputLinks + (crt * NCardsInCrate + crd) * NInputWordsInCard;
+      if(!unpack(crt, crd, cardLinks, cardLinks + NTowerWordsInCard)) return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,73 @@
+#ifndef UCTLinkUnpacker_hh
+#define UCTLinkUnpacker_hh
+
+// UCT CTP7 input link unpacker
+// Decodes link ordered ECAL and HCAL input words straight into the towers
+// through a precomputed (link, channel) to tower table, bypassing the
+// per-TP setECALData/setHCALData dispatch.
+//
+// The input links follow the same link and channel map as the output
+// links (see UCTLinkPacker.hh).  Per card the input holds:
+//   NLinksInCard links of NChannelsInLink ECAL words
+//   NLinksInCard links of NChannelsInLink HCAL words
+// ECAL word: ET in bits 0-7, FG in bit 8
+// HCAL word: ET in bits 0-7, feature bits in bits 8-13
+// Words in unused channels are ignored.  Cards follow one another in
+// (crate, card) order.
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "UCTGeometry.hh"
+#include "UCTLinkPacker.hh"
+
+class UCTLayer1;
+class UCTTower;
+
+#define NInputWordsInCard (2 * NTowerWordsInCard)
+
+class UCTLinkUnpacker {
+public:
+
+  UCTLinkUnpacker(UCTLayer1& layer1);
+
+  virtual ~UCTLinkUnpacker() {;}
+
+  // Sets the inputs of all towers of one card, so clearEvent() is not needed
+
+  bool unpack(uint32_t crate, uint32_t card, const uint16_t* ecalLinks, const uint16_t* hcalLinks);
+
+  // Sets the inputs of all towers of all cards
+
+  bool unpack(const uint16_t* inputLinks, size_t size);
+
+  static const size_t size() {return NCrates * NCardsInCrate * NInputWordsInCard;}
+
+private:
+
+  // No default constructor is needed
+
+  UCTLinkUnpacker();
+
+  // No copy constructor is needed
+
+  UCTLinkUnpacker(const UCTLinkUnpacker&);
+
+  // No equality operator is needed
+
+  const UCTLinkUnpacker& operator=(const UCTLinkUnpacker&);
+
+  // Precomputed tower for every used (link, channel) of every card
+
+  struct LinkChannel {
+    uint32_t word;
+    UCTTower* tower;
+  };
+
+  std::vector<LinkChannel> linkChannels;
+  std::vector<uint32_t> cardStart;
+
+};
+
+#endif
@@ -0,0 +1,137 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTMetrics.hh"
+
+UCTMetrics::UCTMetrics(const std::string& f, uint32_t i) :
+  fileName(f),
+  intervalSeconds(i > 0 ? i : 1),
+  nValues(0),
+  values(0),
+  stopping(false) {
+}
+
+UCTMetrics::~UCTMetrics() {
+  if(writer.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(writerMutex);
+      stopping = true;
+    }
+    writerWakeUp.notify_one();
+    writer.join();
+    // The final values, after the last update
+    write();
+  }
+  if(values != 0) delete [] values;
+}
+
+uint32_t UCTMetrics::define(const std::string& name, const std::string& help, const std::string& labels,
+			    Type type, double scale, uint32_t n) {
+  if(values != 0) {
+    std::cerr << "UCTMetrics: Cannot define " << name << " after start() -- bailing" << std::endl;
+    exit(1);
+  }
+  Metric m;
+  m.name = name;
+  m.help = help;
+  m.labels = labels;
+  m.type = type;
+  m.scale = scale;
+  m.first = nValues;
+  metrics.push_back(m);
+  nValues += n;
+  return metrics.size() - 1;
+}
+
+uint32_t UCTMetrics::addCounter(const std::string& name, const std::string& help,
+				const std::string& labels, double scale) {
+  return define(name, help, labels, Counter, scale, 1);
+}
+
+uint32_t UCTMetrics::addGauge(const std::string& name, const std::string& help,
+			      const std::string& labels, double scale) {
+  return define(name, help, labels, Gauge, scale, 1);
+}
+
+uint32_t UCTMetrics::addHistogram(const std::string& name, const std::string& help,
+				  const std::vector<double>& bounds, double scale) {
+  uint32_t metric = define(name, help, "", Histogram, scale, bounds.size() + 2);
+  Metric& m = metrics[metric];
+  m.scaledBounds = bounds;
+  for(uint32_t i = 0; i < bounds.size(); i++) {
+    m.bounds.push_back((uint64_t) (bounds[i] / scale + 0.5));
+  }
+  return metric;
+}
+
+bool UCTMetrics::start() {
+  if(values != 0) return false;
+  values = new std::atomic<uint64_t>[nValues > 0 ? nValues : 1];
+  for(uint32_t i = 0; i < nValues; i++) values[i].store(0);
+  if(!write()) return false;
+  writer = std::thread(&UCTMetrics::run, this);
+  return true;
+}
+
+void UCTMetrics::run() {
+  std::unique_lock<std::mutex> lock(writerMutex);
+  while(!stopping) {
+    if(writerWakeUp.wait_for(lock, std::chrono::seconds(intervalSeconds), [this] {return stopping;})) break;
+    lock.unlock();
+    write();
+    lock.lock();
+  }
+}
+
+bool UCTMetrics::write() {
+  if(values == 0) return false;
+  std::ostringstream text;
+  text << std::setprecision(12);
+  for(uint32_t i = 0; i < metrics.size(); i++) {
+    const Metric& m = metrics[i];
+    if(i == 0 || metrics[i - 1].name != m.name) {
+      static const char* typeNames[] = {"counter", "gauge", "histogram"};
+      text << "# HELP " << m.name << " " << m.help << "\n"
+	   << "# TYPE " << m.name << " " << typeNames[m.type] << "\n";
+    }
+    if(m.type != Histogram) {
+      text << m.name;
+      if(!m.labels.empty()) text << "{" << m.labels << "}";
+      text << " " << values[m.first].load(std::memory_order_relaxed) * m.scale << "\n";
+      continue;
+    }
+    // Buckets are counted separately and written cumulatively; the count
+    // is their sum so that it always agrees with the +Inf bucket
+    uint64_t count = 0;
+    for(uint32_t b = 0; b <= m.bounds.size(); b++) {
+      count += values[m.first + b].load(std::memory_order_relaxed);
+      text << m.name << "_bucket{le=\"";
+      if(b < m.bounds.size()) text << m.scaledBounds[b];
+      else text << "+Inf";
+      text << "\"} " << count << "\n";
+    }
+    text << m.name << "_sum " << values[m.first + m.bounds.size() + 1].load(std::memory_order_relaxed) * m.scale << "\n"
+	 << m.name << "_count " << count << "\n";
+  }
+  std::lock_guard<std::mutex> lock(fileMutex);
+  std::string temporary = fileName + ".tmp";
+  std::ofstream file(temporary.c_str());
+  file << text.str();
+  file.close();
+  if(!file || rename(temporary.c_str(), fileName.c_str()) != 0) {
+    std::cerr << "UCTMetrics: Failed to write " << fileName << std::endl;
+    return false;
+  }
+  return true;
+}
+
+uint64_t UCTMetrics::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>
+    (std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,130 @@
+#ifndef UCTMetrics_hh
+#define UCTMetrics_hh
+
+// UCT job metrics exported to a local text file in the Prometheus
+// exposition format, for the textfile collector of a node exporter.
+// Metrics are defined before start().  Updates from the event loop are
+// relaxed atomic additions and take no locks; a writer thread rewrites the
+// file every interval, and once more when the object is destroyed.  The
+// file is written under a temporary name and renamed, so that readers
+// never see it half written.
+// Values are kept as 64-bit integers and written multiplied by the scale
+// of their metric (e.g. 1e-9 for times counted in nanoseconds).
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+
+class UCTMetrics {
+public:
+
+  enum Type {Counter = 0, Gauge, Histogram};
+
+  UCTMetrics(const std::string& fileName, uint32_t intervalSeconds);
+
+  virtual ~UCTMetrics();
+
+  // Definitions; labels is a Prometheus label list such as stage="input"
+  // Samples of the same name must be defined one after the other, and
+  // share the help text of the first.  Histogram bounds are in scaled
+  // units and in increasing order; the +Inf bucket is implicit.
+  // Each returns the handle for the updates.
+
+  uint32_t addCounter(const std::string& name, const std::string& help,
+		      const std::string& labels = "", double scale = 1.);
+  uint32_t addGauge(const std::string& name, const std::string& help,
+		    const std::string& labels = "", double scale = 1.);
+  uint32_t addHistogram(const std::string& name, const std::string& help,
+			const std::vector<double>& bounds, double scale = 1.);
+
+  // Allocates the values and starts the writer thread
+
+  bool start();
+
+  // Lock-free updates, in units of the scale of the metric
+
+  void add(uint32_t metric, uint64_t value = 1) {
+    values[metrics[metric].first].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  void set(uint32_t metric, uint64_t value) {
+    values[metrics[metric].first].store(value, std::memory_order_relaxed);
+  }
+
+  void observe(uint32_t metric, uint64_t value) {
+    const Metric& m = metrics[metric];
+    uint32_t bucket = 0;
+    while(bucket < m.bounds.size() && value > m.bounds[bucket]) bucket++;
+    values[m.first + bucket].fetch_add(1, std::memory_order_relaxed);
+    values[m.first + m.bounds.size() + 1].fetch_add(value, std::memory_order_relaxed);
+  }
+
+  // Writes the file now; normally left to the writer thread
+  // Writes are serialized, but never wait for the event loop
+
+  bool write();
+
+  const std::string& getFileName() const {return fileName;}
+
+  // Monotonic clock in nanoseconds, for timing metrics with scale 1e-9
+
+  static uint64_t now();
+
+private:
+
+  // No default constructor is needed
+
+  UCTMetrics();
+
+  // No copy constructor is needed
+
+  UCTMetrics(const UCTMetrics&);
+
+  // No equality operator is needed
+
+  const UCTMetrics& operator=(const UCTMetrics&);
+
+  struct Metric {
+    std::string name;
+    std::string help;
+    std::string labels;
+    Type type;
+    double scale;
+    // Histogram bucket bounds in unscaled units
+    std::vector<uint64_t> bounds;
+    std::vector<double> scaledBounds;
+    // Index of the first value; histograms have one per bucket, the +Inf
+    // bucket and the sum
+    uint32_t first;
+  };
+
+  uint32_t define(const std::string& name, const std::string& help, const std::string& labels,
+		  Type type, double scale, uint32_t nValues);
+
+  void run();
+
+  std::string fileName;
+  uint32_t intervalSeconds;
+
+  std::vector<Metric> metrics;
+  uint32_t nValues;
+  std::atomic<uint64_t>* values;
+
+  // Used by the writer thread and the destructor only
+
+  std::thread writer;
+  std::mutex writerMutex;
+  std::condition_variable writerWakeUp;
+  bool stopping;
+
+  // Serializes write()
+
+  std::mutex fileMutex;
+
+};
+
+#endif
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTPileupEstimator.hh"
+
+#include "UCTLayer1.hh"
+#include "UCTCrate.hh"
+#include "UCTCard.hh"
+#include "UCTRegion.hh"
+#include "UCTTower.hh"
+
+#include "UCTGeometry.hh"
+
+UCTPileupEstimator::UCTPileupEstimator(UCTLayer1& l, uint32_t shift) :
+  layer1(l),
+  averageShift(shift),
+  nEvents(0),
+  towerAverages(2 * MaxCaloEta + 1, 0),
+  regionAverages(MaxUCTRegionsEta, 0),
+  towersInRing(2 * MaxCaloEta + 1, 0) {
+  const UCTCrateList& crates = l.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  towersInRing[towers[twr]->caloEta() + MaxCaloEta]++;
+	}
+      }
+    }
+  }
+}
+
+bool UCTPileupEstimator::update() {
+  int32_t shift = (nEvents == 0 ? 0 : averageShift);
+  for(int caloEta = -MaxCaloEta; caloEta <= MaxCaloEta; caloEta++) {
+    int32_t& average = towerAverages[caloEta + MaxCaloEta];
+    int32_t et = layer1.getTowerRingET(caloEta) << PileupFractionBits;
+    average += (et - average) >> shift;
+  }
+  for(int ring = 0; ring < MaxUCTRegionsEta; ring++) {
+    int regionEta = (ring < MaxUCTRegionsEta / 2 ? ring - MaxUCTRegionsEta / 2 : ring - MaxUCTRegionsEta / 2 + 1);
+    int32_t& average = regionAverages[ring];
+    int32_t et = layer1.getRegionRingET(regionEta) << PileupFractionBits;
+    average += (et - average) >> shift;
+  }
+  nEvents++;
+  return true;
+}
+
+void UCTPileupEstimator::reset() {
+  std::fill(towerAverages.begin(), towerAverages.end(), 0);
+  std::fill(regionAverages.begin(), regionAverages.end(), 0);
+  nEvents = 0;
+}
+
+float UCTPileupEstimator::getTowerRingPileup(int caloEta) const {
+  if(abs(caloEta) > MaxCaloEta) return 0;
+  return ((float) towerAverages[caloEta + MaxCaloEta]) / (1 << PileupFractionBits);
+}
+
+float UCTPileupEstimator::getRegionRingPileup(int regionEta) const {
+  if(regionEta == 0 || abs(regionEta) > MaxUCTRegionsEta / 2) return 0;
+  uint32_t ring = (regionEta < 0 ? (MaxUCTRegionsEta / 2 + regionEta) : (MaxUCTRegionsEta / 2 + regionEta - 1));
+  return ((float) regionAverages[ring]) / (1 << PileupFractionBits);
+}
+
+float UCTPileupEstimator::getTowerPileupDensity(int caloEta) const {
+  if(abs(caloEta) > MaxCaloEta || towersInRing[caloEta + MaxCaloEta] == 0) return 0;
+  return getTowerRingPileup(caloEta) / towersInRing[caloEta + MaxCaloEta];
+}
+
+void UCTPileupEstimator::print() {
+  std::cout << "UCTPileupEstimator: Average region ring ET after " << nEvents 
+	    << " events (1/" << (1 << averageShift) << " weight)" << std::endl;
+  std::cout << "  Eta ";
+  for(int regionEta = -MaxUCTRegionsEta / 2; regionEta <= MaxUCTRegionsEta / 2; regionEta++) {
+    if(regionEta == 0) continue;
+    std::cout << std::setw(7) << regionEta;
+  }
+  std::cout << std::endl << "  ET  ";
+  for(int regionEta = -MaxUCTRegionsEta / 2; regionEta <= MaxUCTRegionsEta / 2; regionEta++) {
+    if(regionEta == 0) continue;
+    std::cout << std::setw(7) << std::fixed << std::setprecision(1) << getRegionRingPileup(regionEta);
+  }
+  std::cout << std::endl;
+}
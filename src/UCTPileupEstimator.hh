@@ -0,0 +1,75 @@
+#ifndef UCTPileupEstimator_hh
+#define UCTPileupEstimator_hh
+
+// UCT online pileup estimate
+// Exponentially weighted running average of the per eta ring tower and
+// region ET of UCTLayer1, updated once per event:
+//   average += (ringET - average) / 2^averageShift
+// Averages are kept as fixed point with PileupFractionBits fractional
+// bits, so that no past events are stored and the update is a fixed
+// number of integer operations.  The first event after a reset seeds the
+// averages directly.
+
+#include <vector>
+#include <stdint.h>
+
+#include "UCTGeometry.hh"
+
+class UCTLayer1;
+
+#define PileupFractionBits 8
+
+class UCTPileupEstimator {
+public:
+
+  UCTPileupEstimator(UCTLayer1& layer1, uint32_t averageShift = 5);
+
+  virtual ~UCTPileupEstimator() {;}
+
+  // To be called after UCTLayer1::process()
+
+  bool update();
+
+  void reset();
+
+  // Average ring ET, indexed as in UCTLayer1::getTowerRingET and getRegionRingET
+
+  float getTowerRingPileup(int caloEta) const;
+  float getRegionRingPileup(int regionEta) const;
+
+  // Average ET per tower or per region in the ring
+
+  float getTowerPileupDensity(int caloEta) const;
+  float getRegionPileupDensity(int regionEta) const {return getRegionRingPileup(regionEta) / (MaxUCTRegionsPhi);}
+
+  const uint32_t getAverageShift() const {return averageShift;}
+  const uint32_t getNEvents() const {return nEvents;}
+
+  void print();
+
+private:
+
+  // No default constructor is needed
+
+  UCTPileupEstimator();
+
+  // No copy constructor is needed
+
+  UCTPileupEstimator(const UCTPileupEstimator&);
+
+  // No equality operator is needed
+
+  const UCTPileupEstimator& operator=(const UCTPileupEstimator&);
+
+  const UCTLayer1& layer1;
+
+  uint32_t averageShift;
+  uint32_t nEvents;
+
+  std::vector<int32_t> towerAverages;
+  std::vector<int32_t> regionAverages;
+  std::vector<uint32_t> towersInRing;
+
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <stdlib.h>
 #include <stdint.h>
+#include <new>
 
 #include <bitset>
 using std::bitset;
@@ -13,6 +14,8 @@ using std::string;
 
 #include "UCTTower.hh"
 
+#include "UCTRegionVeto.hh"
+
 // Activity fraction to determine how active a tower compared to a region is
 // To avoid ratio calculation, one can use comparison to bit-shifted RegionET
 // (activityLevelShift, %) = (1, 50%), (2, 25%), (3, 12.5%), (4, 6.125%), (5, 3.0625%)
@@ -25,26 +28,29 @@ const float miscActivityFraction = 0.1;
 
 bool vetoBit(bitset<4> etaPattern, bitset<4> phiPattern);
 
-UCTRegion::UCTRegion(uint32_t crt, uint32_t crd, bool ne, uint32_t rgn) :
+UCTRegion::UCTRegion(uint32_t crt, uint32_t crd, bool ne, uint32_t rgn, UCTArena& arena) :
   crate(crt),
   card(crd),
   region(rgn),
   negativeEta(ne),
+  towers(UCTArenaAllocator<UCTTower*>(arena)),
   regionSummary(0) {
   UCTGeometry g;
   uint32_t nEta = g.getNEta(region);
   uint32_t nPhi = g.getNPhi(region);
-  towers.clear();
+  towers.reserve(nEta * nPhi);
   for(uint32_t iEta = 0; iEta < nEta; iEta++) {
     for(uint32_t iPhi = 0; iPhi < nPhi; iPhi++) {
-      towers.push_back(new UCTTower(crate, card, ne, region, iEta, iPhi));
+      void* p = arena.allocate<UCTTower>(UCTArena::TowerPool);
+      towers.push_back(new (p) UCTTower(crate, card, ne, region, iEta, iPhi));
     }
   }
 }
 
 UCTRegion::~UCTRegion() {
+  // Towers live in the arena; only their destructors are run here
   for(uint32_t i = 0; i < towers.size(); i++) {
-    if(towers[i] != 0) delete towers[i];
+    if(towers[i] != 0) towers[i]->~UCTTower();
   }
 }
 
@@ -58,19 +64,38 @@ const UCTTower* UCTRegion::getTower(uint32_t caloEta, uint32_t caloPhi) const {
 }
 
 bool UCTRegion::process() {
+  if(region < CaloHFRegionStart) return process<NEtaInRegion, NPhiInRegion, true>();
+  if(region < CaloVHFRegionStart) return process<NHFEtaInRegion, NHFPhiInRegion, false>();
+  return process<NHFEtaInRegion, NVHFPhiInCard, false>();
+}
 
-  // Determine region dimension
-  UCTGeometry g;
-  uint32_t nEta = g.getNEta(region);
-  uint32_t nPhi = g.getNPhi(region);
+bool UCTRegion::summarize(bool withVetoBits) {
+  if(region < CaloHFRegionStart) return summarize<NEtaInRegion, NPhiInRegion, true>(withVetoBits);
+  if(region < CaloVHFRegionStart) return summarize<NHFEtaInRegion, NHFPhiInRegion, false>(withVetoBits);
+  return summarize<NHFEtaInRegion, NVHFPhiInCard, false>(withVetoBits);
+}
 
-  // Process towers and calculate total ET for the region
-  uint32_t regionET = 0;
-  for(uint32_t twr = 0; twr < towers.size(); twr++) {
+template <uint32_t nEta, uint32_t nPhi, bool isCentral>
+bool UCTRegion::process(bool withVetoBits) {
+
+  // Process towers
+  for(uint32_t twr = 0; twr < nEta * nPhi; twr++) {
     if(!towers[twr]->process()) {
       std::cerr << "Tower level processing failed. Bailing out :(" << std::endl;
       return false;
     }
+  }
+
+  return summarize<nEta, nPhi, isCentral>(withVetoBits);
+
+}
+
+template <uint32_t nEta, uint32_t nPhi, bool isCentral>
+bool UCTRegion::summarize(bool withVetoBits) {
+
+  // Calculate total ET for the region
+  uint32_t regionET = 0;
+  for(uint32_t twr = 0; twr < nEta * nPhi; twr++) {
     regionET += towers[twr]->et();
   }
   if(regionET > RegionETMask) regionET = RegionETMask;
@@ -78,7 +103,7 @@ bool UCTRegion::process() {
 
   // For central regions determine extra bits
 
-  if(region < NRegionsInCard) {
+  if(isCentral) {
     uint32_t highestTowerET = 0;
     uint32_t highestTowerLocation = 0;
     for(uint32_t iPhi = 0; iPhi < nPhi; iPhi++) {
@@ -91,42 +116,184 @@ bool UCTRegion::process() {
       }
     }
     regionSummary |= (highestTowerLocation << LocationShift);
+    if(!withVetoBits) return true;
+    // Veto bits with the default activity fractions
+    uint32_t vetoBits = 0;
+    if(!computeVetoBits(&getDefaultThresholds(), 1, &vetoBits)) return false;
+    regionSummary |= vetoBits;
   }
   
-  // Calculate regionEcalET 
+  return true;
+
+}
+
+bool UCTRegion::process(const uint32_t* towerInputs, uint32_t* towerData, uint32_t* summary) const {
+  if(region < CaloHFRegionStart)
+    return process<NEtaInRegion, NPhiInRegion, true>(towerInputs, towerData, summary);
+  if(region < CaloVHFRegionStart)
+    return process<NHFEtaInRegion, NHFPhiInRegion, false>(towerInputs, towerData, summary);
+  return process<NHFEtaInRegion, NVHFPhiInCard, false>(towerInputs, towerData, summary);
+}
+
+template <uint32_t nEta, uint32_t nPhi, bool isCentral>
+bool UCTRegion::process(const uint32_t* towerInputs, uint32_t* towerData, uint32_t* summary) const {
+
+  // Process towers, each for all lanes
+  for(uint32_t twr = 0; twr < nEta * nPhi; twr++) {
+    towers[twr]->process(&towerInputs[twr * BatchLanes], &towerData[twr * BatchLanes]);
+  }
+
+  // Calculate total ET for the region
+  uint32_t regionET[BatchLanes];
+  for(uint32_t l = 0; l < BatchLanes; l++) regionET[l] = 0;
+  for(uint32_t twr = 0; twr < nEta * nPhi; twr++) {
+    const uint32_t* data = &towerData[twr * BatchLanes];
+    for(uint32_t l = 0; l < BatchLanes; l++) regionET[l] += (data[l] & etMask);
+  }
+  for(uint32_t l = 0; l < BatchLanes; l++) {
+    if(regionET[l] > RegionETMask) regionET[l] = RegionETMask;
+    summary[l] = regionET[l];
+  }
 
+  if(!isCentral) return true;
+
+  // Highest tower, in the order of summarize()
+  uint32_t highestTowerET[BatchLanes];
+  uint32_t highestTowerLocation[BatchLanes];
+  for(uint32_t l = 0; l < BatchLanes; l++) {
+    highestTowerET[l] = 0;
+    highestTowerLocation[l] = 0;
+  }
+  for(uint32_t iPhi = 0; iPhi < nPhi; iPhi++) {
+    for(uint32_t iEta = 0; iEta < nEta; iEta++) {
+      const uint32_t* data = &towerData[(iEta*nEta+iPhi) * BatchLanes];
+      for(uint32_t l = 0; l < BatchLanes; l++) {
+	uint32_t towerET = (data[l] & etMask);
+	bool higher = (highestTowerET[l] < towerET);
+	highestTowerET[l] = (higher ? towerET : highestTowerET[l]);
+	highestTowerLocation[l] = (higher ? iEta*nEta+iPhi : highestTowerLocation[l]);
+      }
+    }
+  }
+
+  // Veto bits as in UCTRegionVeto, with one bit per lane in the active
+  // tower planes, so that the patterns of all lanes are decided at once
+  const UCTRegionThresholds& thresholds = getDefaultThresholds();
+  uint32_t activityLevel[BatchLanes];
+  uint32_t activeTowerET[BatchLanes];
+  uint32_t regionEcalET[BatchLanes];
+  for(uint32_t l = 0; l < BatchLanes; l++) {
+    activityLevel[l] = ((uint32_t) ((float) regionET[l]) * thresholds.activityFraction);
+    activeTowerET[l] = 0;
+    regionEcalET[l] = 0;
+  }
+  uint64_t activePlanes[nEta * nPhi];
+  for(uint32_t twr = 0; twr < nEta * nPhi; twr++) {
+    const uint32_t* data = &towerData[twr * BatchLanes];
+    uint32_t active[BatchLanes];
+    for(uint32_t l = 0; l < BatchLanes; l++) {
+      uint32_t et = (data[l] & etMask);
+      active[l] = (et > activityLevel[l]);
+      activeTowerET[l] += (active[l] ? et : 0);
+      regionEcalET[l] += ((data[l] & ecalBitsMask) >> ecalShift);
+    }
+    uint64_t plane = 0;
+    for(uint32_t l = 0; l < BatchLanes; l++) plane |= (((uint64_t) active[l]) << l);
+    activePlanes[twr] = plane;
+  }
+  uint64_t etaPattern[4] = {0, 0, 0, 0};
+  uint64_t phiPattern[4] = {0, 0, 0, 0};
+  for(uint32_t strip = 0; strip < 4; strip++) {
+    uint64_t etaStrip = 0;
+    uint64_t phiStrip = 0;
+    for(uint32_t k = 0; k < 4; k++) {
+      etaStrip |= activePlanes[strip * nEta + k];
+      phiStrip |= activePlanes[k * nEta + strip];
+    }
+    for(uint32_t b = 0; b < 4; b++) {
+      if(((0x1 >> strip) & (0x1 << b)) != 0) {
+	etaPattern[b] |= etaStrip;
+	phiPattern[b] |= phiStrip;
+      }
+    }
+  }
+  uint64_t veto = UCTRegionVeto::patternVeto(etaPattern, phiPattern);
+  uint32_t laneVeto[BatchLanes];
+  for(uint32_t l = 0; l < BatchLanes; l++) laneVeto[l] = ((veto >> l) & 0x1);
+  for(uint32_t l = 0; l < BatchLanes; l++) {
+    uint32_t ecalET = (regionEcalET[l] > RegionETMask ? RegionETMask : regionEcalET[l]);
+    uint32_t activeET = (activeTowerET[l] > RegionETMask ? RegionETMask : activeTowerET[l]);
+    // Region ET is clamped to RegionETMask, so the conversions through
+    // int32_t, which unlike those of uint32_t vectorize, are exact
+    uint32_t maxMiscActivityLevelForEG = (int32_t) ((float) (int32_t) regionET[l] * thresholds.ecalActivityFraction);
+    uint32_t maxMiscActivityLevelForTau = (int32_t) ((float) (int32_t) regionET[l] * thresholds.miscActivityFraction);
+    uint32_t patternVeto = laneVeto[l];
+    uint32_t egVeto = (patternVeto | ((regionET[l] - ecalET) > maxMiscActivityLevelForEG));
+    uint32_t tauVeto = (patternVeto | ((regionET[l] - activeET) > maxMiscActivityLevelForTau));
+    summary[l] |= ((highestTowerLocation[l] << LocationShift) |
+		   (egVeto != 0 ? RegionEGVeto : 0) | (tauVeto != 0 ? RegionTauVeto : 0));
+  }
+
+  return true;
+
+}
+
+template bool UCTRegion::process<NEtaInRegion, NPhiInRegion, true>(bool);
+template bool UCTRegion::process<NHFEtaInRegion, NHFPhiInRegion, false>(bool);
+template bool UCTRegion::process<NHFEtaInRegion, NVHFPhiInCard, false>(bool);
+template bool UCTRegion::summarize<NEtaInRegion, NPhiInRegion, true>(bool);
+template bool UCTRegion::summarize<NHFEtaInRegion, NHFPhiInRegion, false>(bool);
+template bool UCTRegion::summarize<NHFEtaInRegion, NVHFPhiInCard, false>(bool);
+template bool UCTRegion::process<NEtaInRegion, NPhiInRegion, true>(const uint32_t*, uint32_t*, uint32_t*) const;
+template bool UCTRegion::process<NHFEtaInRegion, NHFPhiInRegion, false>(const uint32_t*, uint32_t*, uint32_t*) const;
+template bool UCTRegion::process<NHFEtaInRegion, NVHFPhiInCard, false>(const uint32_t*, uint32_t*, uint32_t*) const;
+
+bool UCTRegion::computeVetoBits(const UCTRegionThresholds* thresholds, uint32_t nThresholds, 
+				uint32_t* vetoBits) const {
+
+  if(region >= NRegionsInCard) return false;
+
+  // Read the tower data once for all threshold sets
+
+  uint32_t towerData[NEtaInRegion * NPhiInRegion];
+  for(uint32_t twr = 0; twr < towers.size(); twr++) {
+    towerData[twr] = towers[twr]->rawData();
+  }
+  return computeVetoBits(towerData, et(), thresholds, nThresholds, vetoBits);
+
+}
+
+bool UCTRegion::computeVetoBits(const uint32_t* towerData, uint32_t regionET,
+				const UCTRegionThresholds* thresholds, uint32_t nThresholds, 
+				uint32_t* vetoBits) const {
+
+  // Central regions only
+  const uint32_t nEta = NEtaInRegion;
+  const uint32_t nPhi = NPhiInRegion;
+
+  uint32_t towerET[nEta * nPhi];
   uint32_t regionEcalET = 0;
-  const std::vector<UCTTower*> towerList = getTowers();
-  for(uint32_t twr = 0; twr < towerList.size(); twr++) {
-    regionEcalET += towerList[twr]->getEcalET();
+  for(uint32_t twr = 0; twr < nEta * nPhi; twr++) {
+    towerET[twr] = (towerData[twr] & etMask);
+    regionEcalET += ((towerData[twr] & ecalBitsMask) >> ecalShift);
   }
   if(regionEcalET > RegionETMask) regionEcalET = RegionETMask;
 
-  // For central regions determine extra bits
-
-  if(region < NRegionsInCard) {
+  for(uint32_t t = 0; t < nThresholds; t++) {
     // Identify active towers
     // Tower ET must be a decent fraction of RegionET
     bool activeTower[nEta][nPhi];
-    uint32_t activityLevel = ((uint32_t) ((float) regionET) * activityFraction);
-    uint32_t nActiveTowers = 0;
+    uint32_t activityLevel = ((uint32_t) ((float) regionET) * thresholds[t].activityFraction);
     uint32_t activeTowerET = 0;
-    uint32_t highestTowerET = 0;
-    uint32_t highestTowerLocation = 0;
     for(uint32_t iPhi = 0; iPhi < nPhi; iPhi++) {
       for(uint32_t iEta = 0; iEta < nEta; iEta++) {
-	uint32_t towerET = towers[iEta*nEta+iPhi]->et();
-	if(towerET > activityLevel) {
+	uint32_t et = towerET[iEta*nEta+iPhi];
+	if(et > activityLevel) {
 	  activeTower[iEta][iPhi] = true;
-	  nActiveTowers++;
-	  activeTowerET += towers[iEta*nEta+iPhi]->et();
+	  activeTowerET += et;
 	}
 	else
 	  activeTower[iEta][iPhi] = false;
-	if(highestTowerET < towerET ) {
-	  highestTowerET = towerET;
-	  highestTowerLocation = iEta*nEta+iPhi;
-	}
       }
     }
     if(activeTowerET > RegionETMask) activeTowerET = RegionETMask;
@@ -151,22 +318,26 @@ bool UCTRegion::process() {
     bool veto = vetoBit(activeTowerEtaPattern, activeTowerPhiPattern);
     bool egVeto = veto;
     bool tauVeto = veto;
-    uint32_t maxMiscActivityLevelForEG = ((uint32_t) ((float) regionET) * ecalActivityFraction);
-    uint32_t maxMiscActivityLevelForTau = ((uint32_t) ((float) regionET) * miscActivityFraction);
+    uint32_t maxMiscActivityLevelForEG = ((uint32_t) ((float) regionET) * thresholds[t].ecalActivityFraction);
+    uint32_t maxMiscActivityLevelForTau = ((uint32_t) ((float) regionET) * thresholds[t].miscActivityFraction);
     if((regionET - regionEcalET) > maxMiscActivityLevelForEG) egVeto = true;
     if((regionET - activeTowerET) > maxMiscActivityLevelForTau) tauVeto = true;
-        
-    if(egVeto) regionSummary |= RegionEGVeto;
-    if(tauVeto) regionSummary |= RegionTauVeto;
-
-    regionSummary |= (highestTowerLocation << LocationShift);
 
+    vetoBits[t] = 0;
+    if(egVeto) vetoBits[t] |= RegionEGVeto;
+    if(tauVeto) vetoBits[t] |= RegionTauVeto;
   }
 
   return true;
 
 }
 
+const UCTRegionThresholds& UCTRegion::getDefaultThresholds() {
+  static const UCTRegionThresholds defaultThresholds = 
+    {activityFraction, ecalActivityFraction, miscActivityFraction};
+  return defaultThresholds;
+}
+
 bool vetoBit(bitset<4> etaPattern, bitset<4> phiPattern) {
 
   bitset<4> badPattern5(string("0101"));
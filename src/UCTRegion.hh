@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "UCTTower.hh"
+#include "UCTArena.hh"
 
 #define RegionETMask  0x000003FF
 #define RegionEGVeto  0x00000400
@@ -11,16 +12,24 @@
 #define RegionLocBits 0x0000F000
 #define LocationShift 12
 
+// Tower activity fractions used to determine the EG and tau veto bits
+
+struct UCTRegionThresholds {
+  float activityFraction;
+  float ecalActivityFraction;
+  float miscActivityFraction;
+};
+
 class UCTRegion {
 public:
 
-  UCTRegion(uint32_t crt, uint32_t crd, bool ne, uint32_t rgn);
+  UCTRegion(uint32_t crt, uint32_t crd, bool ne, uint32_t rgn, UCTArena& arena);
 
   virtual ~UCTRegion();
 
   // To setData for towers before processing
 
-  const std::vector<UCTTower*>& getTowers() {return towers;}
+  const UCTTowerList& getTowers() {return towers;}
 
   // To process event
 
@@ -32,6 +41,43 @@ public:
 		    uint32_t hcalFB, uint32_t hcalET);
   bool process();
 
+  // To recompute the summary from already processed towers only
+  // Without vetoBits the veto bits are left clear, for UCTRegionVeto
+
+  bool summarize(bool vetoBits = true);
+
+  // Processing for a region shape known at compile time, so that the
+  // tower loops are fixed and HF regions skip the central-only code
+  // Instantiated for central (NEtaInRegion x NPhiInRegion, central),
+  // HF (NHFEtaInRegion x NHFPhiInRegion) and very forward HF
+  // (NHFEtaInRegion x NVHFPhiInCard) regions; the generic calls above
+  // dispatch on the region number
+
+  template <uint32_t nEta, uint32_t nPhi, bool isCentral> bool process(bool vetoBits = true);
+  template <uint32_t nEta, uint32_t nPhi, bool isCentral> bool summarize(bool vetoBits = true);
+
+  // Processing of BatchLanes events at once (see UCTBatch), with the
+  // default veto thresholds; towerInputs and towerData hold BatchLanes
+  // words per tower of the region, tower after tower, and summary one
+  // region summary per lane
+
+  bool process(const uint32_t* towerInputs, uint32_t* towerData, uint32_t* summary) const;
+
+  template <uint32_t nEta, uint32_t nPhi, bool isCentral>
+  bool process(const uint32_t* towerInputs, uint32_t* towerData, uint32_t* summary) const;
+
+  // Veto bits (RegionEGVeto | RegionTauVeto) for several threshold sets at
+  // once, reading the processed tower data only once; central regions only
+
+  bool computeVetoBits(const UCTRegionThresholds* thresholds, uint32_t nThresholds, 
+		       uint32_t* vetoBits) const;
+
+  static const UCTRegionThresholds& getDefaultThresholds();
+
+  // To restore a previously processed state
+
+  bool setState(uint32_t summary) {regionSummary = summary; return true;}
+
   // Packed data access
 
   const uint32_t rawData() const {return regionSummary;}
@@ -94,6 +140,10 @@ private:
 
   const UCTRegion& operator=(const UCTRegion&);
 
+  bool computeVetoBits(const uint32_t* towerData, uint32_t regionET,
+		       const UCTRegionThresholds* thresholds, uint32_t nThresholds, 
+		       uint32_t* vetoBits) const;
+
 protected:
 
   // Helper functions
@@ -109,7 +159,7 @@ protected:
 
   // Owned region level data 
 
-  std::vector<UCTTower*> towers;
+  UCTTowerList towers;
 
   uint32_t regionSummary;
 
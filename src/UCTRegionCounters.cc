@@ -0,0 +1,80 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTRegionCounters.hh"
+
+#include "UCTLayer1.hh"
+#include "UCTCrate.hh"
+#include "UCTCard.hh"
+#include "UCTRegion.hh"
+
+#include "UCTGeometry.hh"
+
+UCTRegionCounters::UCTRegionCounters(UCTLayer1& layer1) :
+  eventCounts(NCounters * NRegionEtaRings * NRegionETBins, 0),
+  runCounts(NCounters * NRegionEtaRings * NRegionETBins, 0),
+  jobCounts(NCounters * NRegionEtaRings * NRegionETBins, 0),
+  nRunEvents(0),
+  nJobEvents(0) {
+  const UCTCrateList& crates = layer1.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTRegion* region = regions[rgn];
+	if(region->getRegion() < NRegionsInCard) {
+	  centralRegions.push_back(region);
+	  centralRings.push_back(getRing(region->isNegativeEta(), region->getRegion()));
+	}
+      }
+    }
+  }
+}
+
+bool UCTRegionCounters::fill() {
+  std::fill(eventCounts.begin(), eventCounts.end(), 0);
+  for(uint32_t i = 0; i < centralRegions.size(); i++) {
+    const UCTRegion* region = centralRegions[i];
+    uint32_t et = region->et();
+    if(et == 0) continue;
+    uint32_t bin = getETBin(et);
+    eventCounts[index(AllRegions, centralRings[i], bin)]++;
+    if(region->isEGammaLike()) eventCounts[index(EGLikeRegions, centralRings[i], bin)]++;
+    if(region->isTauLike()) eventCounts[index(TauLikeRegions, centralRings[i], bin)]++;
+  }
+  for(uint32_t i = 0; i < eventCounts.size(); i++) {
+    runCounts[i] += eventCounts[i];
+    jobCounts[i] += eventCounts[i];
+  }
+  nRunEvents++;
+  nJobEvents++;
+  return true;
+}
+
+void UCTRegionCounters::beginRun() {
+  std::fill(runCounts.begin(), runCounts.end(), 0);
+  nRunEvents = 0;
+}
+
+void UCTRegionCounters::print(bool run) {
+  const std::vector<uint64_t>& counts = (run ? runCounts : jobCounts);
+  uint64_t nEvents = (run ? nRunEvents : nJobEvents);
+  std::cout << "UCTRegionCounters: EG-like / tau-like / all regions per event for "
+	    << nEvents << (run ? " run" : " job") << " events" << std::endl;
+  std::cout << "Ring ETBin  EG-like   tau-like  all" << std::endl;
+  if(nEvents == 0) return;
+  for(uint32_t ring = 0; ring < NRegionEtaRings; ring++) {
+    for(uint32_t bin = 0; bin < NRegionETBins; bin++) {
+      uint64_t all = counts[index(AllRegions, ring, bin)];
+      if(all == 0) continue;
+      std::cout << std::dec << std::setw(4) << ring << " " << std::setw(5) << bin << " "
+		<< std::setw(9) << ((double) counts[index(EGLikeRegions, ring, bin)]) / nEvents << " "
+		<< std::setw(9) << ((double) counts[index(TauLikeRegions, ring, bin)]) / nEvents << " "
+		<< std::setw(9) << ((double) all) / nEvents << std::endl;
+    }
+  }
+}
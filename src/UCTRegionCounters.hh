@@ -0,0 +1,93 @@
+#ifndef UCTRegionCounters_hh
+#define UCTRegionCounters_hh
+
+// UCT region EG/tau rate counters
+// Counts central regions with non-zero ET, and those among them that are
+// EG-like and tau-like, per region eta ring and per region ET bin.
+// ET bins are powers of two: bin n holds 2^n <= ET < 2^(n+1).
+// Counters are kept for the last event, for the current run and for the
+// job, as plain counters of the one emulator instance they are attached to.
+
+#include <vector>
+#include <stdint.h>
+
+#include "UCTGeometry.hh"
+#include "UCTRegion.hh"
+
+class UCTLayer1;
+
+#define NRegionEtaRings (NSides * NRegionsInCard)
+#define NRegionETBins 10
+
+class UCTRegionCounters {
+public:
+
+  enum Counter {AllRegions = 0, EGLikeRegions, TauLikeRegions, NCounters};
+
+  UCTRegionCounters(UCTLayer1& layer1);
+
+  virtual ~UCTRegionCounters() {;}
+
+  // To be called after UCTLayer1::process()
+
+  bool fill();
+
+  void beginRun();
+
+  // Ring is 0 for the most negative eta ring through NRegionEtaRings - 1
+
+  static uint32_t getRing(bool negativeEta, uint32_t region) {
+    return (negativeEta ? (NRegionsInCard - 1 - region) : (NRegionsInCard + region));
+  }
+
+  static uint32_t getETBin(uint32_t et) {
+    uint32_t bin = 0;
+    while((et >>= 1) != 0) bin++;
+    return (bin < NRegionETBins ? bin : NRegionETBins - 1);
+  }
+
+  const uint32_t getEventCount(Counter c, uint32_t ring, uint32_t bin) const {
+    return eventCounts[index(c, ring, bin)];
+  }
+  const uint64_t getRunCount(Counter c, uint32_t ring, uint32_t bin) const {
+    return runCounts[index(c, ring, bin)];
+  }
+  const uint64_t getJobCount(Counter c, uint32_t ring, uint32_t bin) const {
+    return jobCounts[index(c, ring, bin)];
+  }
+
+  const uint64_t getNRunEvents() const {return nRunEvents;}
+  const uint64_t getNJobEvents() const {return nJobEvents;}
+
+  void print(bool run = false);
+
+private:
+
+  // No default constructor is needed
+
+  UCTRegionCounters();
+
+  // No copy constructor is needed
+
+  UCTRegionCounters(const UCTRegionCounters&);
+
+  // No equality operator is needed
+
+  const UCTRegionCounters& operator=(const UCTRegionCounters&);
+
+  static uint32_t index(Counter c, uint32_t ring, uint32_t bin) {
+    return (c * NRegionEtaRings + ring) * NRegionETBins + bin;
+  }
+
+  std::vector<const UCTRegion*> centralRegions;
+  std::vector<uint32_t> centralRings;
+
+  std::vector<uint32_t> eventCounts;
+  std::vector<uint64_t> runCounts;
+  std::vector<uint64_t> jobCounts;
+  uint64_t nRunEvents;
+  uint64_t nJobEvents;
+
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTRegionVeto.hh"
+
+#include "UCTLayer1.hh"
+#include "UCTCrate.hh"
+#include "UCTCard.hh"
+#include "UCTRegion.hh"
+#include "UCTTower.hh"
+
+UCTRegionVeto::UCTRegionVeto(UCTLayer1& layer1) {
+  const UCTCrateList& crates = layer1.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& cardRegions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < cardRegions.size(); rgn++) {
+	if(cardRegions[rgn]->getRegion() < NRegionsInCard) regions.push_back(cardRegions[rgn]);
+      }
+    }
+  }
+  if(regions.size() > NVetoPlaneWords * VetoPlaneBits) {
+    std::cerr << "UCTRegionVeto: Too many central regions " << regions.size() << " -- bailing" << std::endl;
+    exit(1);
+  }
+}
+
+bool UCTRegionVeto::process(const UCTRegionThresholds& thresholds) {
+
+  memset(activePlanes, 0, sizeof(activePlanes));
+  memset(egETVeto, 0, sizeof(egETVeto));
+  memset(tauETVeto, 0, sizeof(tauETVeto));
+
+  // Gather: active towers and ET fraction conditions, one bit per region
+
+  for(uint32_t i = 0; i < regions.size(); i++) {
+    UCTRegion* region = regions[i];
+    const UCTTowerList& towers = region->getTowers();
+    uint32_t word = i / VetoPlaneBits;
+    uint64_t bit = (((uint64_t) 1) << (i % VetoPlaneBits));
+    uint32_t regionET = region->et();
+    uint32_t activityLevel = ((uint32_t) ((float) regionET) * thresholds.activityFraction);
+    uint32_t activeTowerET = 0;
+    uint32_t regionEcalET = 0;
+    for(uint32_t twr = 0; twr < towers.size(); twr++) {
+      uint32_t et = towers[twr]->et();
+      regionEcalET += towers[twr]->getEcalET();
+      if(et > activityLevel) {
+	activePlanes[twr][word] |= bit;
+	activeTowerET += et;
+      }
+    }
+    if(regionEcalET > RegionETMask) regionEcalET = RegionETMask;
+    if(activeTowerET > RegionETMask) activeTowerET = RegionETMask;
+    uint32_t maxMiscActivityLevelForEG = ((uint32_t) ((float) regionET) * thresholds.ecalActivityFraction);
+    uint32_t maxMiscActivityLevelForTau = ((uint32_t) ((float) regionET) * thresholds.miscActivityFraction);
+    if((regionET - regionEcalET) > maxMiscActivityLevelForEG) egETVeto[word] |= bit;
+    if((regionET - activeTowerET) > maxMiscActivityLevelForTau) tauETVeto[word] |= bit;
+  }
+
+  // Word-wide pattern veto
+  // Pattern bit b is set by the strips whose (0x1 >> strip) has bit b, as
+  // in UCTRegion::computeVetoBits()
+
+  uint64_t egVeto[NVetoPlaneWords];
+  uint64_t tauVeto[NVetoPlaneWords];
+  for(uint32_t w = 0; w < NVetoPlaneWords; w++) {
+    uint64_t etaPattern[4] = {0, 0, 0, 0};
+    uint64_t phiPattern[4] = {0, 0, 0, 0};
+    for(uint32_t strip = 0; strip < 4; strip++) {
+      uint64_t etaStrip = 0;
+      uint64_t phiStrip = 0;
+      for(uint32_t k = 0; k < 4; k++) {
+	etaStrip |= activePlanes[strip * NEtaInRegion + k][w];
+	phiStrip |= activePlanes[k * NEtaInRegion + strip][w];
+      }
+      for(uint32_t b = 0; b < 4; b++) {
+	if(((0x1 >> strip) & (0x1 << b)) != 0) {
+	  etaPattern[b] |= etaStrip;
+	  phiPattern[b] |= phiStrip;
+	}
+      }
+    }
+    uint64_t veto = patternVeto(etaPattern, phiPattern);
+    egVeto[w] = (veto | egETVeto[w]);
+    tauVeto[w] = (veto | tauETVeto[w]);
+  }
+
+  // Scatter to the region summaries
+
+  for(uint32_t i = 0; i < regions.size(); i++) {
+    uint32_t word = i / VetoPlaneBits;
+    uint32_t shift = i % VetoPlaneBits;
+    uint32_t vetoBits = 0;
+    if(((egVeto[word] >> shift) & 0x1) != 0) vetoBits |= RegionEGVeto;
+    if(((tauVeto[word] >> shift) & 0x1) != 0) vetoBits |= RegionTauVeto;
+    regions[i]->setState(regions[i]->rawData() | vetoBits);
+  }
+
+  return true;
+
+}
+
+uint64_t UCTRegionVeto::patternVeto(const uint64_t etaPattern[4], const uint64_t phiPattern[4]) {
+  // A pattern is vetoed unless it has at most one bit set or is two
+  // adjacent bits, i.e. for bits (a, b, c, d) from the bottom when
+  // (a & c) | (a & d) | (b & d)
+  return ((etaPattern[0] & etaPattern[2]) | (etaPattern[0] & etaPattern[3]) | (etaPattern[1] & etaPattern[3]) |
+	  (phiPattern[0] & phiPattern[2]) | (phiPattern[0] & phiPattern[3]) | (phiPattern[1] & phiPattern[3]));
+}
@@ -0,0 +1,70 @@
+#ifndef UCTRegionVeto_hh
+#define UCTRegionVeto_hh
+
+// UCT layer-wide EG and tau veto evaluation
+// The active towers of all central regions are gathered into bit planes,
+// one bit per region, so that the eta and phi patterns and the pattern
+// veto of all regions are decided by a few word-wide logical operations.
+// The ET fraction conditions are also kept as planes and are ORed in,
+// and the veto bits are then scattered back to the region summaries.
+// The result is identical to the per-region UCTRegion::computeVetoBits().
+
+#include <vector>
+#include <stdint.h>
+
+#include "UCTGeometry.hh"
+
+class UCTLayer1;
+class UCTRegion;
+struct UCTRegionThresholds;
+
+#define VetoPlaneBits 64
+#define NVetoPlaneWords ((NCrates * NCardsInCrate * NRegionsInCard * 2 + VetoPlaneBits - 1) / VetoPlaneBits)
+
+class UCTRegionVeto {
+public:
+
+  UCTRegionVeto(UCTLayer1& layer1);
+
+  virtual ~UCTRegionVeto() {;}
+
+  // To be called once the region ET is summarized; the veto bits of the
+  // regions must still be clear
+
+  bool process(const UCTRegionThresholds& thresholds);
+
+  const uint32_t getNRegions() const {return regions.size();}
+
+  // Pattern veto of 64 regions at once; bit i of pattern[b] is bit b of the
+  // 4-bit eta or phi pattern of region i, and bit i of the result is its veto
+
+  static uint64_t patternVeto(const uint64_t etaPattern[4], const uint64_t phiPattern[4]);
+
+private:
+
+  // No default constructor is needed
+
+  UCTRegionVeto();
+
+  // No copy constructor is needed
+
+  UCTRegionVeto(const UCTRegionVeto&);
+
+  // No equality operator is needed
+
+  const UCTRegionVeto& operator=(const UCTRegionVeto&);
+
+  // Central regions; region i is bit (i % VetoPlaneBits) of word (i / VetoPlaneBits)
+
+  std::vector<UCTRegion*> regions;
+
+  // Active tower planes in the region tower order (iEta * NEtaInRegion + iPhi)
+  // and the ET fraction veto planes
+
+  uint64_t activePlanes[NEtaInRegion * NPhiInRegion][NVetoPlaneWords];
+  uint64_t egETVeto[NVetoPlaneWords];
+  uint64_t tauETVeto[NVetoPlaneWords];
+
+};
+
+#endif
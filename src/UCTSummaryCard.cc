@@ -0,0 +1,155 @@
+#include <iostream>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTSummaryCard.hh"
+
+#include "UCTLayer1.hh"
+#include "UCTCrate.hh"
+#include "UCTCard.hh"
+#include "UCTRegion.hh"
+
+#include "UCTGeometry.hh"
+
+// Default seeds are in region ET units
+
+const UCTSummaryThresholds defaultSummaryThresholds = {10, 5, 5, 0.25};
+
+UCTSummaryCard::UCTSummaryCard(UCTLayer1& layer1) :
+  thresholds(defaultSummaryThresholds),
+  regionET(NPaddedPhi * NPaddedEta, 0),
+  egLike(NPaddedPhi * NPaddedEta, 0),
+  tauLike(NPaddedPhi * NPaddedEta, 0),
+  rowSumET(NPaddedPhi * NPaddedEta, 0),
+  windowET(NPaddedPhi * NPaddedEta, 0) {
+  const UCTCrateList& crates = layer1.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	UCTRegionIndex r = regions[rgn]->regionIndex();
+	gridRegions.push_back(regions[rgn]);
+	gridCells.push_back(cell(r.second, getEtaColumn(r.first)));
+      }
+    }
+  }
+}
+
+bool UCTSummaryCard::process() {
+
+  jets.clear();
+  egCandidates.clear();
+  tauCandidates.clear();
+
+  // Fill the grid
+
+  for(uint32_t i = 0; i < gridRegions.size(); i++) {
+    const UCTRegion* region = gridRegions[i];
+    uint32_t c = gridCells[i];
+    regionET[c] = region->et();
+    bool central = (region->getRegion() < NRegionsInCard);
+    egLike[c] = (central && region->isEGammaLike());
+    tauLike[c] = (central && region->isTauLike());
+  }
+
+  // Phi wraparound padding rows
+
+  std::copy(&regionET[NSummaryPhi * NPaddedEta], &regionET[(NSummaryPhi + 1) * NPaddedEta], &regionET[0]);
+  std::copy(&regionET[NPaddedEta], &regionET[2 * NPaddedEta], &regionET[(NSummaryPhi + 1) * NPaddedEta]);
+
+  // 3x3 window sums: 3-wide sums along eta, then 3-high sums along phi
+
+  for(uint32_t p = 0; p < NPaddedPhi; p++) {
+    const uint32_t* in = &regionET[p * NPaddedEta];
+    uint32_t* out = &rowSumET[p * NPaddedEta];
+    for(uint32_t e = 1; e <= NSummaryEta; e++) {
+      out[e] = in[e - 1] + in[e] + in[e + 1];
+    }
+  }
+  for(uint32_t p = 1; p <= NSummaryPhi; p++) {
+    const uint32_t* up = &rowSumET[(p - 1) * NPaddedEta];
+    const uint32_t* mid = &rowSumET[p * NPaddedEta];
+    const uint32_t* down = &rowSumET[(p + 1) * NPaddedEta];
+    uint32_t* out = &windowET[p * NPaddedEta];
+    for(uint32_t e = 1; e <= NSummaryEta; e++) {
+      out[e] = up[e] + mid[e] + down[e];
+    }
+  }
+  std::copy(&windowET[NSummaryPhi * NPaddedEta], &windowET[(NSummaryPhi + 1) * NPaddedEta], &windowET[0]);
+  std::copy(&windowET[NPaddedEta], &windowET[2 * NPaddedEta], &windowET[(NSummaryPhi + 1) * NPaddedEta]);
+
+  // Neighbour offsets; ties are won by the cell with lower (phi, eta)
+
+  const int before[4] = {-NPaddedEta - 1, -NPaddedEta, -NPaddedEta + 1, -1};
+  const int after[4] = {1, NPaddedEta - 1, NPaddedEta, NPaddedEta + 1};
+
+  for(uint32_t phi = 0; phi < NSummaryPhi; phi++) {
+    for(uint32_t eta = 0; eta < NSummaryEta; eta++) {
+      uint32_t c = cell(phi, eta);
+      uint32_t et = regionET[c];
+      if(et == 0) continue;
+
+      // The seed region must be the highest in its 3x3 neighbourhood
+
+      bool highest = true;
+      uint32_t highestNeighbourET = 0;
+      for(uint32_t n = 0; n < 4; n++) {
+	if(regionET[c + before[n]] >= et) highest = false;
+	if(regionET[c + after[n]] > et) highest = false;
+	highestNeighbourET = std::max(highestNeighbourET, regionET[c + before[n]]);
+	highestNeighbourET = std::max(highestNeighbourET, regionET[c + after[n]]);
+      }
+      if(!highest) continue;
+
+      // Jets
+
+      if(et > thresholds.jetSeed) {
+	jets.push_back(makeObject(phi, eta, windowET[c], false));
+      }
+
+      // EG and tau candidates from central regions
+
+      uint32_t neighbourET = windowET[c] - et;
+      bool isolated = (neighbourET < thresholds.isolationFraction * et);
+      if(egLike[c] && et > thresholds.egSeed) {
+	egCandidates.push_back(makeObject(phi, eta, et, isolated));
+      }
+      if(tauLike[c] && et > thresholds.tauSeed) {
+	uint32_t tauET = et + highestNeighbourET;
+	bool tauIsolated = (neighbourET - highestNeighbourET < thresholds.isolationFraction * tauET);
+	tauCandidates.push_back(makeObject(phi, eta, tauET, tauIsolated));
+      }
+    }
+  }
+
+  return true;
+
+}
+
+UCTSummaryObject UCTSummaryCard::makeObject(uint32_t phi, uint32_t eta, uint32_t et, bool isolated) const {
+  UCTSummaryObject o;
+  o.index = UCTRegionIndex(getRegionEtaIndex(eta), phi);
+  o.et = et;
+  o.isolated = isolated;
+  return o;
+}
+
+void UCTSummaryCard::print() {
+  std::cout << "UCTSummaryCard: " << jets.size() << " jets, " 
+	    << egCandidates.size() << " EG and " 
+	    << tauCandidates.size() << " tau candidates" << std::endl;
+  for(uint32_t i = 0; i < jets.size(); i++) {
+    std::cout << "Jet (" << jets[i].index.first << ", " << jets[i].index.second << ") ET = " 
+	      << jets[i].et << std::endl;
+  }
+  for(uint32_t i = 0; i < egCandidates.size(); i++) {
+    std::cout << "EG  (" << egCandidates[i].index.first << ", " << egCandidates[i].index.second << ") ET = " 
+	      << egCandidates[i].et << (egCandidates[i].isolated ? " isolated" : "") << std::endl;
+  }
+  for(uint32_t i = 0; i < tauCandidates.size(); i++) {
+    std::cout << "Tau (" << tauCandidates[i].index.first << ", " << tauCandidates[i].index.second << ") ET = " 
+	      << tauCandidates[i].et << (tauCandidates[i].isolated ? " isolated" : "") << std::endl;
+  }
+}
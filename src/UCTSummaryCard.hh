@@ -0,0 +1,120 @@
+#ifndef UCTSummaryCard_hh
+#define UCTSummaryCard_hh
+
+// UCT summary card emulation
+// Runs after UCTLayer1::process() on the grid of region summaries:
+//   MaxUCTRegionsPhi (18) phi rows x MaxUCTRegionsEta (26) eta columns
+// Grid eta column 0 is the most negative HF region and column 25 the most
+// positive one; phi row is the UCTRegionPhiIndex.
+// The grid is stored as a contiguous array padded by one row/column on all
+// sides.  Phi padding rows are copies of the opposite edge (wraparound),
+// eta padding columns are zero.  3x3 window sums are computed as 3-wide
+// row sums followed by 3-high column sums, both of which are plain loops
+// over contiguous memory.
+//
+// Objects are seeded by regions that are the highest in their 3x3
+// neighbourhood; ties go to the region with the lower (phi, eta)
+//   Jets: seeds above the jet seed, with the 3x3 window ET
+//   EG:   EG-like central seeds above the EG seed, with the region ET;
+//         isolated if the neighbour ET is below isolationFraction of it
+//   Tau:  tau-like central seeds above the tau seed, with the ET of the
+//         region plus its highest neighbour; isolated likewise
+
+#include <vector>
+#include <stdint.h>
+
+#include "UCTGeometry.hh"
+
+class UCTLayer1;
+class UCTRegion;
+
+#define NSummaryPhi (MaxUCTRegionsPhi)
+#define NSummaryEta (MaxUCTRegionsEta)
+#define NPaddedPhi (NSummaryPhi + 2)
+#define NPaddedEta (NSummaryEta + 2)
+
+struct UCTSummaryObject {
+  UCTRegionIndex index;
+  uint32_t et;
+  bool isolated;
+};
+
+struct UCTSummaryThresholds {
+  uint32_t jetSeed;
+  uint32_t egSeed;
+  uint32_t tauSeed;
+  float isolationFraction;
+};
+
+class UCTSummaryCard {
+public:
+
+  UCTSummaryCard(UCTLayer1& layer1);
+
+  virtual ~UCTSummaryCard() {;}
+
+  void setThresholds(const UCTSummaryThresholds& t) {thresholds = t;}
+  const UCTSummaryThresholds& getThresholds() const {return thresholds;}
+
+  // To be called after UCTLayer1::process()
+
+  bool process();
+
+  const std::vector<UCTSummaryObject>& getJets() const {return jets;}
+  const std::vector<UCTSummaryObject>& getEGCandidates() const {return egCandidates;}
+  const std::vector<UCTSummaryObject>& getTauCandidates() const {return tauCandidates;}
+
+  // Grid access by (phi row, eta column) without padding
+
+  const uint32_t getRegionET(uint32_t phi, uint32_t eta) const {return regionET[cell(phi, eta)];}
+  const uint32_t getWindowET(uint32_t phi, uint32_t eta) const {return windowET[cell(phi, eta)];}
+
+  static uint32_t getEtaColumn(int regionEtaIndex) {
+    return (regionEtaIndex < 0 ? (NSummaryEta / 2 + regionEtaIndex) : (NSummaryEta / 2 + regionEtaIndex - 1));
+  }
+  static int getRegionEtaIndex(uint32_t etaColumn) {
+    return (etaColumn < NSummaryEta / 2 ? ((int) etaColumn - NSummaryEta / 2) : ((int) etaColumn - NSummaryEta / 2 + 1));
+  }
+
+  void print();
+
+private:
+
+  // No default constructor is needed
+
+  UCTSummaryCard();
+
+  // No copy constructor is needed
+
+  UCTSummaryCard(const UCTSummaryCard&);
+
+  // No equality operator is needed
+
+  const UCTSummaryCard& operator=(const UCTSummaryCard&);
+
+  static uint32_t cell(uint32_t phi, uint32_t eta) {return (phi + 1) * NPaddedEta + (eta + 1);}
+
+  UCTSummaryObject makeObject(uint32_t phi, uint32_t eta, uint32_t et, bool isolated) const;
+
+  UCTSummaryThresholds thresholds;
+
+  // Region feeding each grid cell
+
+  std::vector<const UCTRegion*> gridRegions;
+  std::vector<uint32_t> gridCells;
+
+  // Padded grids
+
+  std::vector<uint32_t> regionET;
+  std::vector<uint8_t> egLike;
+  std::vector<uint8_t> tauLike;
+  std::vector<uint32_t> rowSumET;
+  std::vector<uint32_t> windowET;
+
+  std::vector<UCTSummaryObject> jets;
+  std::vector<UCTSummaryObject> egCandidates;
+  std::vector<UCTSummaryObject> tauCandidates;
+
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include <iostream>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTThresholdScan.hh"
+
+#include "UCTLayer1.hh"
+#include "UCTCrate.hh"
+#include "UCTCard.hh"
+#include "UCTRegion.hh"
+
+#include "UCTGeometry.hh"
+
+UCTThresholdScan::UCTThresholdScan(UCTLayer1& layer1, const std::vector<UCTRegionThresholds>& t) :
+  thresholds(t),
+  vetoBits(t.size(), 0),
+  eventEGCounts(t.size(), 0),
+  eventTauCounts(t.size(), 0),
+  totalEGCounts(t.size(), 0),
+  totalTauCounts(t.size(), 0),
+  nEvents(0) {
+  const UCTCrateList& crates = layer1.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	if(regions[rgn]->getRegion() < NRegionsInCard) centralRegions.push_back(regions[rgn]);
+      }
+    }
+  }
+}
+
+bool UCTThresholdScan::scan() {
+  for(uint32_t t = 0; t < thresholds.size(); t++) {
+    eventEGCounts[t] = 0;
+    eventTauCounts[t] = 0;
+  }
+  if(thresholds.size() == 0) return true;
+  for(uint32_t i = 0; i < centralRegions.size(); i++) {
+    const UCTRegion* region = centralRegions[i];
+    if(region->et() == 0) continue;
+    if(!region->computeVetoBits(&thresholds[0], thresholds.size(), &vetoBits[0])) return false;
+    for(uint32_t t = 0; t < thresholds.size(); t++) {
+      if((vetoBits[t] & RegionEGVeto) == 0) eventEGCounts[t]++;
+      if((vetoBits[t] & RegionTauVeto) == 0) eventTauCounts[t]++;
+    }
+  }
+  for(uint32_t t = 0; t < thresholds.size(); t++) {
+    totalEGCounts[t] += eventEGCounts[t];
+    totalTauCounts[t] += eventTauCounts[t];
+  }
+  nEvents++;
+  return true;
+}
+
+void UCTThresholdScan::print() {
+  std::cout << "UCTThresholdScan: " << nEvents << " events" << std::endl;
+  std::cout << "activity ecalActivity miscActivity EG-like/event tau-like/event" << std::endl;
+  for(uint32_t t = 0; t < thresholds.size(); t++) {
+    double egPerEvent = (nEvents > 0 ? ((double) totalEGCounts[t]) / nEvents : 0.);
+    double tauPerEvent = (nEvents > 0 ? ((double) totalTauCounts[t]) / nEvents : 0.);
+    std::cout << thresholds[t].activityFraction << " "
+	      << thresholds[t].ecalActivityFraction << " "
+	      << thresholds[t].miscActivityFraction << " "
+	      << egPerEvent << " "
+	      << tauPerEvent << std::endl;
+  }
+}
@@ -0,0 +1,66 @@
+#ifndef UCTThresholdScan_hh
+#define UCTThresholdScan_hh
+
+// UCT region veto threshold scan
+// Evaluates the EG and tau veto bits of all central regions for a list of
+// activity fraction configurations in one pass over the processed towers,
+// and counts the EG-like and tau-like regions for each configuration.
+// To be called after UCTLayer1::process(); the emulator output itself is
+// always made with the default thresholds.
+
+#include <vector>
+#include <stdint.h>
+
+#include "UCTRegion.hh"
+
+class UCTLayer1;
+
+class UCTThresholdScan {
+public:
+
+  UCTThresholdScan(UCTLayer1& layer1, const std::vector<UCTRegionThresholds>& thresholds);
+
+  virtual ~UCTThresholdScan() {;}
+
+  bool scan();
+
+  // Counts of EG-like and tau-like central regions with non-zero ET
+  // for each configuration, for the last event and for all events
+
+  const std::vector<UCTRegionThresholds>& getThresholds() const {return thresholds;}
+  const std::vector<uint32_t>& getEventEGCounts() const {return eventEGCounts;}
+  const std::vector<uint32_t>& getEventTauCounts() const {return eventTauCounts;}
+  const std::vector<uint64_t>& getTotalEGCounts() const {return totalEGCounts;}
+  const std::vector<uint64_t>& getTotalTauCounts() const {return totalTauCounts;}
+  const uint64_t getNEvents() const {return nEvents;}
+
+  void print();
+
+private:
+
+  // No default constructor is needed
+
+  UCTThresholdScan();
+
+  // No copy constructor is needed
+
+  UCTThresholdScan(const UCTThresholdScan&);
+
+  // No equality operator is needed
+
+  const UCTThresholdScan& operator=(const UCTThresholdScan&);
+
+  std::vector<UCTRegionThresholds> thresholds;
+  std::vector<const UCTRegion*> centralRegions;
+
+  std::vector<uint32_t> vetoBits;
+
+  std::vector<uint32_t> eventEGCounts;
+  std::vector<uint32_t> eventTauCounts;
+  std::vector<uint64_t> totalEGCounts;
+  std::vector<uint64_t> totalTauCounts;
+  uint64_t nEvents;
+
+};
+
+#endif
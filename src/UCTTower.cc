@@ -8,40 +8,87 @@
 #include "UCTTower.hh"
 
 bool UCTTower::process() {
-  towerData = ecalET + hcalET;
-  if(towerData > etMask) towerData = etMask;
+  towerData = compute(ecalET, hcalET, hcalFB, ecalFG);
+  return true;
+}
+
+void UCTTower::process(const uint32_t* inputs, uint32_t* data) const {
+  // Masks, flags and look-ups first, into local arrays so that the rest
+  // is a branch-free loop over the lanes that the compiler vectorizes
+  // The flags are HCAL feature bit 0 (input bit 16) and ECAL FG (input
+  // bit 22), of unmasked channels only
+  uint32_t flagMask = (((hcalMask & 0x1) != 0 ? hcalFlagMask : 0) | (ecalMask != 0 ? ecalFlagMask : 0));
+  uint32_t calEcalET[BatchLanes];
+  uint32_t calHcalET[BatchLanes];
+  uint32_t flags[BatchLanes];
+  for(uint32_t l = 0; l < BatchLanes; l++) {
+    calEcalET[l] = (inputs[l] & ecalMask);
+    calHcalET[l] = ((inputs[l] >> 8) & hcalMask);
+    flags[l] = ((((inputs[l] >> 2) & hcalFlagMask) | ((inputs[l] >> 7) & ecalFlagMask)) & flagMask);
+  }
+  if(ecalLUT != 0) {
+    for(uint32_t l = 0; l < BatchLanes; l++) calEcalET[l] = ecalLUT[calEcalET[l]];
+  }
+  if(hcalLUT != 0) {
+    for(uint32_t l = 0; l < BatchLanes; l++) calHcalET[l] = hcalLUT[calHcalET[l]];
+  }
+  for(uint32_t l = 0; l < BatchLanes; l++) {
+    uint32_t e = calEcalET[l];
+    uint32_t h = calHcalET[l];
+    uint32_t et = (e + h > etMask ? etMask : e + h);
+    // er as in log2Ratio(), counting the erMaxV (7) shifts of the smaller
+    // ET that do not exceed the larger one
+    uint32_t larger = (e > h ? e : h);
+    uint32_t smaller = (e > h ? h : e);
+    uint32_t er = (((smaller << 1) <= larger) + ((smaller << 2) <= larger) + ((smaller << 3) <= larger) +
+		   ((smaller << 4) <= larger) + ((smaller << 5) <= larger) + ((smaller << 6) <= larger) +
+		   ((smaller << 7) <= larger));
+    uint32_t zero = ((e == 0) | (h == 0));
+    uint32_t d = et | (zero ? zeroFlagMask : (er << erShift));
+    d |= ((e != 0) & (e >= h)) ? eohrFlagMask : 0;
+    data[l] = d | flags[l] | (e << ecalShift) | (h << hcalShift);
+  }
+}
+
+uint32_t UCTTower::compute(uint32_t ecalET, uint32_t hcalET, uint32_t hcalFB, bool ecalFG) const {
+  // Inputs are limited to 8 bits, so the look-up is always in range
+  // Masked channels contribute nothing, including their flag bits
+  uint32_t maskedEcalET = (ecalET & ecalMask);
+  uint32_t maskedHcalET = (hcalET & hcalMask);
+  uint32_t calEcalET = (ecalLUT != 0 ? ecalLUT[maskedEcalET] : maskedEcalET);
+  uint32_t calHcalET = (hcalLUT != 0 ? hcalLUT[maskedHcalET] : maskedHcalET);
+  uint32_t data = calEcalET + calHcalET;
+  if(data > etMask) data = etMask;
   uint32_t er = 0;
-  if(ecalET == 0 || hcalET == 0) {
+  if(calEcalET == 0 || calHcalET == 0) {
     er = 0;
-    towerData |= zeroFlagMask;
-    if(hcalET == 0 && ecalET != 0)
-      towerData |= eohrFlagMask;
+    data |= zeroFlagMask;
+    if(calHcalET == 0 && calEcalET != 0)
+      data |= eohrFlagMask;
   }
-  else if(ecalET == hcalET) {
+  else if(calEcalET == calHcalET) {
     er = 0;
-    towerData |= eohrFlagMask;
+    data |= eohrFlagMask;
   }
-  else if(ecalET > hcalET) {
-    er = (uint32_t) log2(((double) ecalET) / ((double) hcalET));
-    if(er > erMaxV) er = erMaxV;
-    towerData |= eohrFlagMask;
+  else if(calEcalET > calHcalET) {
+    er = log2Ratio(calEcalET, calHcalET);
+    data |= eohrFlagMask;
   }
   else {
-    er = (uint32_t) log2(((double) hcalET) / ((double) ecalET));
-    if(er > erMaxV) er = erMaxV;
+    er = log2Ratio(calHcalET, calEcalET);
   }
-  towerData |= (er << erShift);
+  data |= (er << erShift);
   // Unfortunately, hcalFlag is presently bogus :(
   // It has never been studied nor used in Run-1
   // The same status persists in Run-2, but it is available usage
   // Currently, summarize all hcalFeatureBits in one flag bit
-  if((hcalFB & 0x1) != 0) towerData |= hcalFlagMask; // FIXME - ignore top bits if(hcalFB != 0)
-  if(ecalFG) towerData |= ecalFlagMask;
+  if((hcalFB & hcalMask & 0x1) != 0) data |= hcalFlagMask; // FIXME - ignore top bits if(hcalFB != 0)
+  if(ecalFG && ecalMask != 0) data |= ecalFlagMask;
   // Store ecal and hcal calibrated ET in unused upper bits
-  towerData |= (ecalET << ecalShift);
-  towerData |= (hcalET << hcalShift);
+  data |= (calEcalET << ecalShift);
+  data |= (calHcalET << hcalShift);
   // All done!
-  return true;
+  return data;
 }
 
 bool UCTTower::setECALData(bool eFG, uint32_t eET) {
@@ -87,6 +134,8 @@ UCTTower::UCTTower(uint16_t location) {
   region = (location & 0x00F0) >>  4;
   iEta =   (location & 0x000C) >>  2;
   iPhi =   (location & 0x0003);
+  ecalLUT = 0;
+  hcalLUT = 0;
   towerData = 0;
 }
 
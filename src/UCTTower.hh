@@ -20,6 +20,10 @@
 #define hcalBitsMask 0xFF000000
 #define hcalShift 24
 
+// Number of events processed at once by the lane kernels of UCTBatch
+
+#define BatchLanes 16
+
 class UCTLayer1;
 
 class UCTTower {
@@ -36,6 +40,10 @@ public:
     ecalET(0),
     hcalET(0),
     hcalFB(0),
+    ecalLUT(0),
+    hcalLUT(0),
+    ecalMask(0xFF),
+    hcalMask(0xFF),
     towerData(0)
   {}
 
@@ -61,8 +69,61 @@ public:
   bool setECALData(bool ecalFG, uint32_t ecalET);
   bool setHCALData(uint32_t hcalET, uint32_t hcalFB);
 
+  // Input link words are already limited to the hardware bit fields, so
+  // no checks are needed here
+  // ECAL word: ET (8 bits), FG (1 bit); HCAL word: ET (8 bits), FB (6 bits)
+
+  void setLinkData(uint16_t ecalWord, uint16_t hcalWord) {
+    ecalET = (ecalWord & 0xFF);
+    ecalFG = ((ecalWord & 0x100) != 0);
+    hcalET = (hcalWord & 0xFF);
+    hcalFB = ((hcalWord >> 8) & 0x3F);
+  }
+
+  // Calibration look-up tables indexed by compressed ET; null for none
+  // The tables are not owned by the tower
+
+  void setCalibrationLUTs(const uint8_t* eLUT, const uint8_t* hLUT) {
+    ecalLUT = eLUT;
+    hcalLUT = hLUT;
+  }
+
+  // Channel masks, ANDed with the inputs while processing
+  // Masked inputs are kept, so that the masked energy can be counted
+
+  void setChannelMask(bool ecalMasked, bool hcalMasked) {
+    ecalMask = (ecalMasked ? 0 : 0xFF);
+    hcalMask = (hcalMasked ? 0 : 0xFF);
+  }
+
+  const bool isECALMasked() const {return (ecalMask == 0);}
+  const bool isHCALMasked() const {return (hcalMask == 0);}
+  const uint32_t getMaskedEcalET() const {return (ecalET & ~ecalMask);}
+  const uint32_t getMaskedHcalET() const {return (hcalET & ~hcalMask);}
+
   bool process();
 
+  // The same for BatchLanes events at once (see UCTBatch), from packed
+  // input words in the inputData() format to packed tower data
+
+  void process(const uint32_t* inputs, uint32_t* data) const;
+
+  // Packed input and output state for snapshot, restore and cloning
+  // Input word: ecalET (8 bits), hcalET (8 bits), hcalFB (6 bits), ecalFG (1 bit)
+
+  const uint32_t inputData() const {
+    return (ecalET | (hcalET << 8) | (hcalFB << 16) | (ecalFG ? 0x00400000 : 0));
+  }
+
+  bool setState(uint32_t input, uint32_t data) {
+    ecalET = (input & 0xFF);
+    hcalET = ((input >> 8) & 0xFF);
+    hcalFB = ((input >> 16) & 0x3F);
+    ecalFG = ((input & 0x00400000) != 0);
+    towerData = data;
+    return true;
+  }
+
   // Packed data access
 
   const uint32_t rawData() const {return towerData;}
@@ -124,6 +185,18 @@ private:
 
   const UCTTower& operator=(const UCTTower&);
 
+  // Packed tower data for one set of inputs
+
+  uint32_t compute(uint32_t ecalET, uint32_t hcalET, uint32_t hcalFB, bool ecalFG) const;
+
+  // floor(log2(a / b)) for a > b > 0, limited to erMaxV
+
+  static uint32_t log2Ratio(uint32_t a, uint32_t b) {
+    uint32_t er = 0;
+    while(er < erMaxV && (b << (er + 1)) <= a) er++;
+    return er;
+  }
+
   // Tower location definition
 
   uint32_t crate;
@@ -140,6 +213,16 @@ private:
   uint32_t hcalET;
   uint32_t hcalFB;
 
+  // Calibration
+
+  const uint8_t* ecalLUT;
+  const uint8_t* hcalLUT;
+
+  // Channel masks: 0xFF to pass, 0 to mask
+
+  uint32_t ecalMask;
+  uint32_t hcalMask;
+
   // Owned tower level data 
   // Packed bits -- only bottom 16 bits are used in "prelim" protocol
 
@@ -0,0 +1,62 @@
+#include <iostream>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTTowerHistory.hh"
+
+#include "UCTLayer1.hh"
+#include "UCTTower.hh"
+
+UCTTowerHistory::UCTTowerHistory(const UCTLayer1& layer1, uint32_t d) :
+  towers(layer1.getAllTowers().begin(), layer1.getAllTowers().end()),
+  nTowers(towers.size()),
+  indexTable((2 * MaxCaloEta + 1) * (MaxCaloPhi + 1), 0),
+  depth(d),
+  head(0),
+  nRecorded(0) {
+  if(depth == 0) {
+    std::cerr << "UCTTowerHistory: Depth must be at least one -- bailing" << std::endl;
+    exit(1);
+  }
+  for(uint32_t i = 0; i < nTowers; i++) {
+    indexTable[(towers[i]->caloEta() + MaxCaloEta) * (MaxCaloPhi + 1) + towers[i]->caloPhi()] = i;
+  }
+  history.assign(depth * nTowers, 0);
+}
+
+uint32_t UCTTowerHistory::getIndex(const UCTTower* tower) const {
+  return indexTable[(tower->caloEta() + MaxCaloEta) * (MaxCaloPhi + 1) + tower->caloPhi()];
+}
+
+bool UCTTowerHistory::record() {
+  // The first crossing goes to slot 0
+  if(nRecorded > 0) head = (head + 1) % depth;
+  uint32_t* out = &history[head * nTowers];
+  for(uint32_t i = 0; i < nTowers; i++) {
+    out[i] = towers[i]->rawData();
+  }
+  nRecorded++;
+  return true;
+}
+
+void UCTTowerHistory::clear() {
+  std::fill(history.begin(), history.end(), 0);
+  head = 0;
+  nRecorded = 0;
+}
+
+uint32_t UCTTowerHistory::getET(uint32_t index, uint32_t bxAgo) const {
+  if(index >= nTowers || bxAgo >= depth) return 0;
+  return (getData(index, bxAgo) & etMask);
+}
+
+uint32_t UCTTowerHistory::getSumET(uint32_t index, uint32_t nBX) const {
+  if(index >= nTowers) return 0;
+  if(nBX > depth) nBX = depth;
+  uint32_t et = 0;
+  for(uint32_t bx = 0; bx < nBX; bx++) {
+    et += (getData(index, bx) & etMask);
+  }
+  return et;
+}
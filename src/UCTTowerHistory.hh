@@ -0,0 +1,92 @@
+#ifndef UCTTowerHistory_hh
+#define UCTTowerHistory_hh
+
+// UCT multi-BX tower history
+// Circular buffer of the packed tower data (UCTTower::rawData()) of the
+// last `depth' crossings.  Each crossing is one contiguous block of words
+// in the order of UCTLayer1::getAllTowers(), so recording a crossing is a
+// single pass over the tower list and advancing the BX only moves the
+// head index.
+// bxAgo = 0 is the most recently recorded crossing.  To see both the
+// previous and next crossings of a BX, record with a delay: the BX of
+// interest is then at bxAgo = depth / 2.
+
+#include <vector>
+#include <stdint.h>
+
+#include "UCTGeometry.hh"
+
+class UCTLayer1;
+class UCTTower;
+
+class UCTTowerHistory {
+public:
+
+  UCTTowerHistory(const UCTLayer1& layer1, uint32_t depth);
+
+  virtual ~UCTTowerHistory() {;}
+
+  // To be called after UCTLayer1::process() for each crossing
+
+  bool record();
+
+  void clear();
+
+  const uint32_t getDepth() const {return depth;}
+  const uint32_t getNRecorded() const {return nRecorded;}
+  const uint32_t getNTowers() const {return nTowers;}
+
+  // Index of a tower in the history; the tower must belong to the layer1
+  // instance the history was made for
+
+  uint32_t getIndex(const UCTTower* tower) const;
+
+  // Packed data and ET of a tower bxAgo crossings back
+
+  uint32_t getData(uint32_t index, uint32_t bxAgo) const {
+    return history[slot(bxAgo) * nTowers + index];
+  }
+  uint32_t getET(uint32_t index, uint32_t bxAgo) const;
+  uint32_t getET(const UCTTower* tower, uint32_t bxAgo) const {return getET(getIndex(tower), bxAgo);}
+
+  // ET of a tower summed over the last nBX crossings
+
+  uint32_t getSumET(uint32_t index, uint32_t nBX) const;
+  uint32_t getSumET(const UCTTower* tower, uint32_t nBX) const {return getSumET(getIndex(tower), nBX);}
+
+  // All towers of one crossing, in the order of UCTLayer1::getAllTowers()
+
+  const uint32_t* getCrossing(uint32_t bxAgo) const {return &history[slot(bxAgo) * nTowers];}
+
+private:
+
+  // No default constructor is needed
+
+  UCTTowerHistory();
+
+  // No copy constructor is needed
+
+  UCTTowerHistory(const UCTTowerHistory&);
+
+  // No equality operator is needed
+
+  const UCTTowerHistory& operator=(const UCTTowerHistory&);
+
+  uint32_t slot(uint32_t bxAgo) const {return (head + depth - (bxAgo % depth)) % depth;}
+
+  std::vector<const UCTTower*> towers;
+  uint32_t nTowers;
+
+  // History index by (caloEta, caloPhi), laid out as the UCTLayer1 tower table
+
+  std::vector<uint32_t> indexTable;
+
+  uint32_t depth;
+  uint32_t head;
+  uint32_t nRecorded;
+
+  std::vector<uint32_t> history;
+
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include <iostream>
+#include <algorithm>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "UCTTowerSumTable.hh"
+
+#include "UCTLayer1.hh"
+#include "UCTCrate.hh"
+#include "UCTCard.hh"
+#include "UCTRegion.hh"
+#include "UCTTower.hh"
+
+#include "UCTGeometry.hh"
+
+UCTTowerSumTable::UCTTowerSumTable(UCTLayer1& layer1) :
+  grid(NSumTablePhi * NSumTableEta, 0),
+  rowPrefix(NSumTableEta + 1, 0),
+  table((NSumTablePhi + 1) * (NSumTableEta + 1), 0) {
+  const UCTCrateList& crates = layer1.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& regionTowers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < regionTowers.size(); twr++) {
+	  const UCTTower* tower = regionTowers[twr];
+	  // 72-bin caloPhi of the first tower position covered
+	  int caloPhi = tower->caloPhi();
+	  if(tower->getRegion() >= CaloVHFRegionStart) caloPhi = 4 * caloPhi - 1;
+	  else if(tower->getRegion() >= CaloHFRegionStart) caloPhi = 2 * caloPhi - 1;
+	  towers.push_back(tower);
+	  cells.push_back((caloPhi - 1) * NSumTableEta + getColumn(tower->caloEta()));
+	}
+      }
+    }
+  }
+}
+
+uint32_t UCTTowerSumTable::getColumn(int caloEta) {
+  uint32_t absCaloEta = abs(caloEta);
+  uint32_t offset = 0;
+  if(absCaloEta >= 1 && absCaloEta <= NEta) offset = absCaloEta - 1;
+  else if(absCaloEta > HFEtaOffset && absCaloEta <= MaxCaloEta) offset = absCaloEta - 2;
+  else return NSumTableEta;
+  return (caloEta < 0 ? (NSumTableEta / 2 - 1 - offset) : (NSumTableEta / 2 + offset));
+}
+
+bool UCTTowerSumTable::build() {
+
+  // Scatter tower ET into the grid
+
+  for(uint32_t i = 0; i < towers.size(); i++) {
+    grid[cells[i]] = towers[i]->et();
+  }
+
+  // Each table row is the row below plus the eta prefix sum of one grid
+  // row; the addition runs over contiguous rows and is vectorized
+
+  const uint32_t w = NSumTableEta + 1;
+  for(uint32_t row = 0; row < NSumTablePhi; row++) {
+    const uint32_t* in = &grid[row * NSumTableEta];
+    uint32_t running = 0;
+    for(uint32_t col = 0; col < NSumTableEta; col++) {
+      running += in[col];
+      rowPrefix[col + 1] = running;
+    }
+    const uint32_t* below = &table[row * w];
+    uint32_t* out = &table[(row + 1) * w];
+    for(uint32_t col = 0; col < w; col++) {
+      out[col] = below[col] + rowPrefix[col];
+    }
+  }
+
+  return true;
+
+}
+
+uint32_t UCTTowerSumTable::sumPhi(int phi0, int phi1, uint32_t col0, uint32_t col1) const {
+  // phi0 and phi1 are 0-based rows; a range of NSumTablePhi or more is all of phi
+  if(phi1 - phi0 + 1 >= NSumTablePhi) return sum(0, NSumTablePhi - 1, col0, col1);
+  phi0 = (phi0 % NSumTablePhi + NSumTablePhi) % NSumTablePhi;
+  phi1 = (phi1 % NSumTablePhi + NSumTablePhi) % NSumTablePhi;
+  if(phi0 <= phi1) return sum(phi0, phi1, col0, col1);
+  return sum(phi0, NSumTablePhi - 1, col0, col1) + sum(0, phi1, col0, col1);
+}
+
+uint32_t UCTTowerSumTable::getET(int caloEtaMin, int caloEtaMax, int caloPhiMin, int caloPhiMax) const {
+  uint32_t col0 = getColumn(caloEtaMin);
+  uint32_t col1 = getColumn(caloEtaMax);
+  if(col0 >= NSumTableEta || col1 >= NSumTableEta || col0 > col1 ||
+     caloPhiMin < 1 || caloPhiMin > NSumTablePhi || caloPhiMax < 1 || caloPhiMax > NSumTablePhi) {
+    std::cerr << "UCTTowerSumTable::getET - Invalid window (" << caloEtaMin << ":" << caloEtaMax << ", "
+	      << caloPhiMin << ":" << caloPhiMax << ")" << std::endl;
+    return 0;
+  }
+  if(caloPhiMin <= caloPhiMax) return sumPhi(caloPhiMin - 1, caloPhiMax - 1, col0, col1);
+  return sumPhi(caloPhiMin - 1, caloPhiMax - 1 + NSumTablePhi, col0, col1);
+}
+
+uint32_t UCTTowerSumTable::getWindowET(int caloEta, int caloPhi, uint32_t halfEta, uint32_t halfPhi) const {
+  uint32_t col = getColumn(caloEta);
+  if(col >= NSumTableEta || caloPhi < 1 || caloPhi > NSumTablePhi) {
+    std::cerr << "UCTTowerSumTable::getWindowET - Invalid tower (" << caloEta << ", " << caloPhi << ")" << std::endl;
+    return 0;
+  }
+  uint32_t col0 = (col > halfEta ? col - halfEta : 0);
+  uint32_t col1 = std::min(col + halfEta, (uint32_t) NSumTableEta - 1);
+  return sumPhi(caloPhi - 1 - (int) halfPhi, caloPhi - 1 + (int) halfPhi, col0, col1);
+}
@@ -0,0 +1,90 @@
+#ifndef UCTTowerSumTable_hh
+#define UCTTowerSumTable_hh
+
+// UCT tower summed-area table
+// Tower ET on a dense grid of MaxCaloPhi (72) phi rows by NSumTableEta (80)
+// eta columns, and its 2D prefix sums, so that the ET in any rectangular
+// eta-phi window is four look-ups.
+// Eta columns run over the existing caloEta values in order:
+//   -41..-30, -28..-1, 1..28, 30..41
+// so that windows step over the missing caloEta 0 and +/-29.
+// HF and VHF towers are wider in phi; their ET is put in the 72-bin phi
+// row of the first tower position they cover.
+// Phi windows wrap around; eta windows are clipped to the grid.
+
+#include <vector>
+#include <stdint.h>
+
+#include "UCTGeometry.hh"
+
+class UCTLayer1;
+class UCTTower;
+
+#define NSumTableEta (2 * (NEta + NHFEta))
+#define NSumTablePhi (MaxCaloPhi)
+
+class UCTTowerSumTable {
+public:
+
+  UCTTowerSumTable(UCTLayer1& layer1);
+
+  virtual ~UCTTowerSumTable() {;}
+
+  // To be called after UCTLayer1::process(), which does so when the
+  // table is enabled there
+
+  bool build();
+
+  // ET of the towers with caloEta in [caloEtaMin, caloEtaMax] and 72-bin
+  // caloPhi in [caloPhiMin, caloPhiMax]; caloPhiMin > caloPhiMax wraps
+
+  uint32_t getET(int caloEtaMin, int caloEtaMax, int caloPhiMin, int caloPhiMax) const;
+
+  // ET of the (2 halfEta + 1) x (2 halfPhi + 1) window centred on a tower
+
+  uint32_t getWindowET(int caloEta, int caloPhi, uint32_t halfEta, uint32_t halfPhi) const;
+
+  // Column of a caloEta, or NSumTableEta if there is no such tower ring
+
+  static uint32_t getColumn(int caloEta);
+
+private:
+
+  // No default constructor is needed
+
+  UCTTowerSumTable();
+
+  // No copy constructor is needed
+
+  UCTTowerSumTable(const UCTTowerSumTable&);
+
+  // No equality operator is needed
+
+  const UCTTowerSumTable& operator=(const UCTTowerSumTable&);
+
+  // Sum of rows [row0, row1] and columns [col0, col1], without wraparound
+
+  uint32_t sum(uint32_t row0, uint32_t row1, uint32_t col0, uint32_t col1) const {
+    const uint32_t w = NSumTableEta + 1;
+    return (table[(row1 + 1) * w + col1 + 1] - table[row0 * w + col1 + 1] -
+	    table[(row1 + 1) * w + col0] + table[row0 * w + col0]);
+  }
+
+  uint32_t sumPhi(int phi0, int phi1, uint32_t col0, uint32_t col1) const;
+
+  // Grid cell of each tower
+
+  std::vector<const UCTTower*> towers;
+  std::vector<uint32_t> cells;
+
+  std::vector<uint32_t> grid;
+  std::vector<uint32_t> rowPrefix;
+
+  // (NSumTablePhi + 1) x (NSumTableEta + 1) with a leading zero row and
+  // column: entry (r, c) is the ET of rows below r and columns below c
+
+  std::vector<uint32_t> table;
+
+};
+
+#endif
@@ -0,0 +1,132 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <map>
+#include <vector>
+#include <stdlib.h>
+#include <stdint.h>
+
+using namespace std;
+
+#include "L1Trigger/L1TCaloLayer1/src/UCTLayer1.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTEventCapture.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTCalibrationLUT.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTChannelMask.hh"
+
+// Replays events captured by L1TCaloLayer1Validator through UCTLayer1 and
+// prints, per event, every tower where the test (hardware), captured
+// emulator and replayed towers do not all agree
+
+// Tower words of one source by (caloEta, caloPhi)
+
+typedef map<pair<int, int>, uint32_t> TowerMap;
+
+void fill(const vector<uint32_t>& words, TowerMap& towers) {
+  towers.clear();
+  for(uint32_t i = 0; i < words.size(); i++) {
+    towers[make_pair(UCTCaptureEvent::getCaloEta(words[i]), UCTCaptureEvent::getCaloPhi(words[i]))] =
+      UCTCaptureEvent::getTowerData(words[i]);
+  }
+}
+
+// Missing towers are empty
+
+uint32_t get(const TowerMap& towers, const pair<int, int>& index) {
+  TowerMap::const_iterator t = towers.find(index);
+  return (t == towers.end() ? EmptyTowerData : t->second);
+}
+
+void printTower(const TowerMap& towers, const pair<int, int>& index) {
+  uint32_t data = get(towers, index);
+  cout << setw(8) << (data & 0x1FF) << setw(4) << ((data >> 9) & 0x7) << setw(4) << ((data >> 12) & 0xF);
+}
+
+int main(int argc, char** argv) {
+
+  string captureFile;
+  string lutFile;
+  string maskFile;
+  for(int i = 1; i < argc; i++) {
+    string arg(argv[i]);
+    if(arg == "-l" && i + 1 < argc) lutFile = argv[++i];
+    else if(arg == "-m" && i + 1 < argc) maskFile = argv[++i];
+    else if(captureFile.empty() && arg[0] != '-') captureFile = arg;
+    else {
+      captureFile.clear();
+      break;
+    }
+  }
+  if(captureFile.empty()) {
+    cout << "Command syntax: replayUCTCapture captureFile [-l calibrationLUTFile] [-m channelMaskFile]" << endl;
+    return 1;
+  }
+
+  // The emulator must be configured as in the job that made the capture
+
+  UCTLayer1 uct;
+  UCTCalibrationLUT lut;
+  UCTChannelMask mask;
+  if(!lutFile.empty() && (!lut.load(lutFile) || !uct.setCalibrationLUT(&lut))) return 1;
+  if(!maskFile.empty() && (!mask.load(maskFile) || !uct.setChannelMask(&mask))) return 1;
+
+  UCTEventCapture capture;
+  if(!capture.openForRead(captureFile)) return 1;
+
+  UCTCaptureEvent event;
+  vector<uint32_t> replayWords;
+  TowerMap test, emul, replay;
+  uint32_t nEvents = 0;
+  uint32_t nTestEmul = 0;
+  uint32_t nTestReplay = 0;
+  uint32_t nEmulReplay = 0;
+  while(capture.read(event)) {
+    nEvents++;
+    bool haveTPs = !(event.ecalTPs.empty() && event.hcalTPs.empty());
+    fill(event.testTowers, test);
+    fill(event.emulTowers, emul);
+    replay.clear();
+    if(haveTPs) {
+      if(!UCTEventCapture::replay(uct, event, replayWords)) {
+	cerr << "replayUCTCapture: Failed to replay event " << event.event << endl;
+	return 1;
+      }
+      fill(replayWords, replay);
+    }
+    cout << "Event " << event.run << ":" << event.lumi << ":" << event.event << "  BX " << event.bx
+	 << "  ECAL TPs " << event.ecalTPs.size() << "  HCAL TPs " << event.hcalTPs.size()
+	 << (haveTPs ? "" : "  (no TPs captured; not replayed)") << endl;
+    cout << setw(8) << "caloEta" << setw(8) << "caloPhi"
+	 << setw(16) << "test ET ER FB" << setw(16) << "emul ET ER FB" << setw(16) << "replay ET ER FB"
+	 << "  differences" << endl;
+
+    // All towers known to any source
+    TowerMap all(test);
+    all.insert(emul.begin(), emul.end());
+    all.insert(replay.begin(), replay.end());
+    for(TowerMap::const_iterator t = all.begin(); t != all.end(); ++t) {
+      bool testEmul = (get(test, t->first) == get(emul, t->first));
+      bool testReplay = (!haveTPs || (get(test, t->first) == get(replay, t->first)));
+      bool emulReplay = (!haveTPs || (get(emul, t->first) == get(replay, t->first)));
+      if(testEmul && testReplay && emulReplay) continue;
+      cout << setw(8) << t->first.first << setw(8) << t->first.second;
+      printTower(test, t->first);
+      printTower(emul, t->first);
+      if(haveTPs) printTower(replay, t->first);
+      else cout << setw(16) << "-";
+      cout << " ";
+      if(!testEmul) {cout << " test!=emul"; nTestEmul++;}
+      if(!testReplay) {cout << " test!=replay"; nTestReplay++;}
+      if(!emulReplay) {cout << " emul!=replay"; nEmulReplay++;}
+      cout << endl;
+    }
+  }
+
+  // Mismatches between the captured and replayed emulator mean that the
+  // emulator or its configuration differs from the capturing job
+
+  cout << "replayUCTCapture: " << nEvents << " events; towers differing test/emul " << nTestEmul
+       << ", test/replay " << nTestReplay << ", emul/replay " << nEmulReplay << endl;
+
+  return 0;
+
+}
@@ -0,0 +1,122 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <stdlib.h>
+#include <stdint.h>
+
+using namespace std;
+
+#include "L1Trigger/L1TCaloLayer1/src/UCTLayer1.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTAllocationCounter.hh"
+
+#include "L1Trigger/L1TCaloLayer1/src/UCTGeometry.hh"
+
+// Reports the heap footprint of UCTLayer1 and the heap allocations of each
+// emulator stage per event, and fails if an event after the warm-up makes
+// more allocations than the budget
+// Counting needs an instrumentation build, with -DUCTCountAllocations for
+// both the package and this program
+
+#define NWarmUpEvents 10
+
+// Random central TPs as (caloEta, caloPhi, et, flag) arrays
+
+struct TPs {
+  vector<int> caloEta;
+  vector<int> caloPhi;
+  vector<uint32_t> et;
+  vector<uint32_t> flag;
+};
+
+void makeTPs(TPs& tps, uint32_t nTPs) {
+  tps.caloEta.resize(nTPs);
+  tps.caloPhi.resize(nTPs);
+  tps.et.resize(nTPs);
+  tps.flag.resize(nTPs);
+  for(uint32_t i = 0; i < nTPs; i++) {
+    tps.caloEta[i] = (random() % 28) + 1;
+    if((random() & 0x1) != 0) tps.caloEta[i] = -tps.caloEta[i];
+    tps.caloPhi[i] = (random() % 72) + 1;
+    tps.et[i] = random() & 0xFF;
+    tps.flag[i] = random() & 0x1;
+  }
+}
+
+int main(int argc, char** argv) {
+
+  uint32_t nEvents = 1000;
+  uint32_t budget = 0;
+  if(argc > 1) nEvents = atoi(argv[1]);
+  if(argc > 2) budget = atoi(argv[2]);
+  if(argc > 3 || nEvents <= NWarmUpEvents) {
+    cout << "Command syntax: testUCTAllocations [nEvents > " << NWarmUpEvents
+	 << "] [allocation budget per event]" << endl;
+    return 1;
+  }
+
+  // Footprint: the arena plus whatever the constructor allocates besides
+
+  int64_t liveBytes = UCTAllocationCounter::getLiveBytes();
+  UCTLayer1* uct = new UCTLayer1;
+  int64_t footprint = UCTAllocationCounter::getLiveBytes() - liveBytes;
+  cout << "testUCTAllocations: UCTLayer1 object " << sizeof(UCTLayer1) << " bytes, arena "
+       << uct->getArena().size() << " bytes (" << uct->getArena().used() << " used)" << endl;
+  if(!UCTAllocationCounter::isEnabled()) {
+    cout << "testUCTAllocations: Built without -DUCTCountAllocations; no allocations counted" << endl;
+    delete uct;
+    return 0;
+  }
+  cout << "testUCTAllocations: UCTLayer1 heap footprint " << footprint << " bytes" << endl;
+
+  TPs ecal;
+  TPs hcal;
+  vector<UCTAllocationCounter::Counts> warmUp(UCTAllocationCounter::NStages);
+  vector<UCTAllocationCounter::Counts> steady(UCTAllocationCounter::NStages);
+  uint64_t maxAllocations = 0;
+  uint32_t nOverBudget = 0;
+  for(uint32_t event = 0; event < nEvents; event++) {
+    // Inputs are made outside the counting
+    makeTPs(ecal, 200 + (random() % 200));
+    makeTPs(hcal, 200 + (random() % 200));
+    UCTAllocationCounter::reset();
+    if(!uct->clearEvent() ||
+       !uct->setECALData(&ecal.caloEta[0], &ecal.caloPhi[0], &ecal.et[0], &ecal.flag[0], ecal.et.size()) ||
+       !uct->setHCALData(&hcal.caloEta[0], &hcal.caloPhi[0], &hcal.et[0], &hcal.flag[0], hcal.et.size()) ||
+       !uct->process()) {
+      cerr << "testUCTAllocations: Processing event " << event << " failed" << endl;
+      return 1;
+    }
+    vector<UCTAllocationCounter::Counts>& sum = (event < NWarmUpEvents) ? warmUp : steady;
+    for(uint32_t stage = 0; stage < UCTAllocationCounter::NStages; stage++) {
+      UCTAllocationCounter::Counts counts = UCTAllocationCounter::get((UCTAllocationCounter::Stage) stage);
+      sum[stage].allocations += counts.allocations;
+      sum[stage].frees += counts.frees;
+      sum[stage].bytes += counts.bytes;
+    }
+    if(event < NWarmUpEvents) continue;
+    uint64_t allocations = UCTAllocationCounter::getTotal().allocations;
+    if(allocations > maxAllocations) maxAllocations = allocations;
+    if(allocations > budget) nOverBudget++;
+  }
+
+  uint32_t nSteady = nEvents - NWarmUpEvents;
+  cout << setw(10) << "stage" << setw(24) << "warm-up allocs/bytes" << setw(30) << "per steady event allocs/bytes" << endl;
+  for(uint32_t stage = 0; stage < UCTAllocationCounter::NStages; stage++) {
+    cout << setw(10) << UCTAllocationCounter::getStageName((UCTAllocationCounter::Stage) stage)
+	 << setw(12) << warmUp[stage].allocations << setw(12) << warmUp[stage].bytes
+	 << setw(15) << fixed << setprecision(2) << (double) steady[stage].allocations / nSteady
+	 << setw(15) << (double) steady[stage].bytes / nSteady << endl;
+  }
+  cout << "testUCTAllocations: At most " << maxAllocations << " allocations in one of " << nSteady
+       << " steady state events; budget " << budget << endl;
+
+  delete uct;
+
+  if(nOverBudget != 0) {
+    cerr << "testUCTAllocations: " << nOverBudget << " events over the allocation budget" << endl;
+    return 1;
+  }
+
+  return 0;
+
+}
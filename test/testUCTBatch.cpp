@@ -0,0 +1,196 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+using namespace std;
+
+#include "L1Trigger/L1TCaloLayer1/src/UCTLayer1.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTCrate.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTCard.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTRegion.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTTower.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTBatch.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTEventCapture.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTCalibrationLUT.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTChannelMask.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTMetrics.hh"
+
+// Replays a capture through UCTEventCapture::replay() one event at a time
+// and through UCTBatch BatchLanes events at a time, checks that the towers,
+// regions, cards, crates and totals of the two agree, and times both
+// Without a capture file, random events on all towers are written to one
+// first, and the comparison is repeated with calibration LUTs and with
+// channel masks
+
+// Random TPs on any tower, ECAL on central towers only
+
+void makeTPs(UCTLayer1& uct, bool ecal, uint32_t nTPs, vector<uint32_t>& words) {
+  const vector<UCTTower*>& towers = uct.getAllTowers();
+  words.clear();
+  while(words.size() < nTPs) {
+    const UCTTower* t = towers[random() % towers.size()];
+    if(ecal && t->getRegion() >= NRegionsInCard) continue;
+    uint32_t flag = (ecal ? (random() & 0x1) : (random() & 0x3F));
+    words.push_back(UCTCaptureEvent::packTP(t->caloEta(), t->caloPhi(), random() & 0xFF, flag));
+  }
+}
+
+bool writeCapture(UCTLayer1& uct, const string& fileName, uint32_t nEvents) {
+  UCTEventCapture capture;
+  if(!capture.openForWrite(fileName)) return false;
+  UCTCaptureEvent event;
+  for(uint32_t e = 0; e < nEvents; e++) {
+    event.clear();
+    event.event = e;
+    makeTPs(uct, true, 100 + (random() % 300), event.ecalTPs);
+    makeTPs(uct, false, 100 + (random() % 300), event.hcalTPs);
+    if(!capture.write(event)) return false;
+  }
+  capture.close();
+  return true;
+}
+
+// Region summaries, card and crate ET and the total, in hierarchy order
+
+void getSummaries(UCTLayer1& uct, vector<uint32_t>& summaries) {
+  vector<uint32_t> cardETs;
+  vector<uint32_t> crateETs;
+  summaries.clear();
+  const UCTCrateList& crates = uct.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) summaries.push_back(regions[rgn]->rawData());
+      cardETs.push_back(cards[crd]->et());
+    }
+    crateETs.push_back(crates[crt]->et());
+  }
+  summaries.insert(summaries.end(), cardETs.begin(), cardETs.end());
+  summaries.insert(summaries.end(), crateETs.begin(), crateETs.end());
+  summaries.push_back(uct.et());
+}
+
+void getSummaries(const UCTBatch& batch, uint32_t lane, vector<uint32_t>& summaries) {
+  summaries.clear();
+  for(uint32_t rgn = 0; rgn < batch.getNRegions(); rgn++) summaries.push_back(batch.getRegionData(lane, rgn));
+  for(uint32_t crd = 0; crd < batch.getNCards(); crd++) summaries.push_back(batch.getCardET(lane, crd));
+  for(uint32_t crt = 0; crt < batch.getNCrates(); crt++) summaries.push_back(batch.getCrateET(lane, crt));
+  summaries.push_back(batch.getSummary(lane));
+}
+
+// Returns false if the replay fails or any event differs
+
+bool compare(UCTLayer1& uct, const vector<UCTCaptureEvent>& events, const string& configuration, bool timing) {
+  uint32_t nEvents = events.size();
+  vector<vector<uint32_t> > perEventTowers(nEvents);
+  vector<vector<uint32_t> > perEventSummaries(nEvents);
+  uint64_t replayTime = 0;
+  uint64_t processTime = 0;
+  for(uint32_t e = 0; e < nEvents; e++) {
+    uint64_t start = UCTMetrics::now();
+    if(!UCTEventCapture::replay(uct, events[e], perEventTowers[e])) return false;
+    replayTime += UCTMetrics::now() - start;
+    // The same inputs once more, for the processing time alone
+    start = UCTMetrics::now();
+    if(!uct.process()) return false;
+    processTime += UCTMetrics::now() - start;
+    getSummaries(uct, perEventSummaries[e]);
+  }
+
+  UCTBatch batch(uct);
+  vector<vector<uint32_t> > towers(nEvents);
+  vector<uint32_t> summaries;
+  uint64_t batchReplayTime = 0;
+  uint64_t batchProcessTime = 0;
+  uint32_t nDiffer = 0;
+  for(uint32_t first = 0; first < nEvents; first += BatchLanes) {
+    uint32_t n = min((uint32_t) BatchLanes, nEvents - first);
+    uint64_t start = UCTMetrics::now();
+    if(!UCTEventCapture::replay(batch, &events[first], n, &towers[first])) return false;
+    batchReplayTime += UCTMetrics::now() - start;
+    start = UCTMetrics::now();
+    if(!batch.process()) return false;
+    batchProcessTime += UCTMetrics::now() - start;
+    for(uint32_t lane = 0; lane < n; lane++) {
+      getSummaries(batch, lane, summaries);
+      if(towers[first + lane] != perEventTowers[first + lane] || summaries != perEventSummaries[first + lane]) {
+	nDiffer++;
+      }
+    }
+  }
+
+  if(timing) {
+    cout << "testUCTBatch: " << nEvents << " events; replay per event " << 1e-3 * replayTime / nEvents
+	 << " us/event, in batches of " << BatchLanes << " " << 1e-3 * batchReplayTime / nEvents << " us/event" << endl;
+    cout << "testUCTBatch: processing alone per event " << 1e-3 * processTime / nEvents
+	 << " us/event, in batches " << 1e-3 * batchProcessTime / nEvents << " us/event" << endl;
+  }
+  if(nDiffer != 0) {
+    cerr << "testUCTBatch: " << nDiffer << " of " << nEvents << " events differ " << configuration << endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+
+  uint32_t nEvents = 1600;
+  string captureFile;
+  if(argc > 1) nEvents = atoi(argv[1]);
+  if(argc > 2) captureFile = argv[2];
+  if(argc > 3 || nEvents == 0) {
+    cout << "Command syntax: testUCTBatch [nEvents] [captureFile]" << endl;
+    return 1;
+  }
+
+  UCTLayer1 uct;
+  bool randomEvents = captureFile.empty();
+  if(randomEvents) {
+    captureFile = "testUCTBatch.dat";
+    if(!writeCapture(uct, captureFile, nEvents)) return 1;
+  }
+
+  // Events with TPs, as replayUCTCapture
+
+  vector<UCTCaptureEvent> events;
+  UCTEventCapture capture;
+  if(!capture.openForRead(captureFile)) return 1;
+  UCTCaptureEvent event;
+  while(events.size() < nEvents && capture.read(event)) {
+    if(!event.ecalTPs.empty() || !event.hcalTPs.empty()) events.push_back(event);
+  }
+  capture.close();
+  if(randomEvents) remove(captureFile.c_str());
+
+  bool ok = compare(uct, events, "", true);
+
+  if(randomEvents) {
+    // Random calibration tables
+    string lutFile = "testUCTBatch.lut";
+    vector<uint8_t> tables(NLUTWords);
+    for(uint32_t i = 0; i < NLUTWords; i++) tables[i] = random() & 0xFF;
+    UCTCalibrationLUT lut;
+    if(!UCTCalibrationLUT::write(lutFile, 1, tables) || !lut.load(lutFile) || !uct.setCalibrationLUT(&lut)) return 1;
+    if(!compare(uct, events, "with calibration LUTs", false)) ok = false;
+    if(!uct.setCalibrationLUT(0)) return 1;
+    lut.unload();
+    remove(lutFile.c_str());
+
+    // Random ECAL and HCAL masks on a tenth of the towers
+    UCTChannelMask mask;
+    const vector<UCTTower*>& towers = uct.getAllTowers();
+    for(uint32_t i = 0; i < towers.size() / 10; i++) {
+      const UCTTower* t = towers[random() % towers.size()];
+      if(!mask.setMask(t->caloEta(), t->caloPhi(), (random() & 0x1), (random() & 0x1))) return 1;
+    }
+    if(!uct.setChannelMask(&mask)) return 1;
+    if(!compare(uct, events, "with channel masks", false)) ok = false;
+  }
+
+  return (ok ? 0 : 1);
+
+}
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <stdlib.h>
+#include <stdint.h>
+
+using namespace std;
+
+#include "L1Trigger/L1TCaloLayer1/src/UCTCInterface.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTMetrics.hh"
+
+// Native driver of the C interface: times uctProcessBatch() on the TP
+// batches saved by testUCTEmulator.py, for comparison with the Python
+// wrapper on the same inputs
+
+// Sparse TPs of one batch, as in UCTCInterface.hh
+
+struct TPs {
+  vector<uint32_t> offsets;
+  vector<int> caloEta;
+  vector<int> caloPhi;
+  vector<uint32_t> et;
+  vector<uint32_t> flag;
+};
+
+template <typename T> bool readArray(ifstream& file, vector<T>& a, uint32_t n) {
+  a.resize(n);
+  return (n == 0 || file.read((char*) &a[0], n * sizeof(T)));
+}
+
+bool readTPs(ifstream& file, TPs& tps, uint32_t nEvents, uint32_t nTPs) {
+  return (readArray(file, tps.offsets, nEvents + 1) &&
+	  readArray(file, tps.caloEta, nTPs) && readArray(file, tps.caloPhi, nTPs) &&
+	  readArray(file, tps.et, nTPs) && readArray(file, tps.flag, nTPs));
+}
+
+int main(int argc, char** argv) {
+
+  if(argc != 2) {
+    cout << "Command syntax: testUCTCInterface tpFile (from testUCTEmulator.py)" << endl;
+    return 1;
+  }
+  ifstream file(argv[1], ios::binary);
+  if(!file) {
+    cerr << "testUCTCInterface: Cannot open " << argv[1] << endl;
+    return 1;
+  }
+
+  UCTLayer1* uct = uctCreate();
+  uint32_t nTowers = uctGetNTowers(uct);
+  uint32_t nRegions = uctGetNRegions(uct);
+  vector<uint32_t> towerData;
+  vector<uint32_t> regionData;
+  vector<uint32_t> summaries;
+  TPs ecal;
+  TPs hcal;
+  uint64_t nEvents = 0;
+  uint64_t elapsed = 0;
+  uint32_t header[3];
+  while(file.read((char*) header, sizeof(header))) {
+    uint32_t nBatch = header[0];
+    if(!readTPs(file, ecal, nBatch, header[1]) || !readTPs(file, hcal, nBatch, header[2])) {
+      cerr << "testUCTCInterface: Truncated batch after " << nEvents << " events" << endl;
+      return 1;
+    }
+    towerData.resize(nBatch * nTowers);
+    regionData.resize(nBatch * nRegions);
+    summaries.resize(nBatch);
+    uint64_t start = UCTMetrics::now();
+    if(!uctProcessBatch(uct, nBatch,
+			&ecal.offsets[0], header[1], &ecal.caloEta[0], &ecal.caloPhi[0], &ecal.et[0], &ecal.flag[0],
+			&hcal.offsets[0], header[2], &hcal.caloEta[0], &hcal.caloPhi[0], &hcal.et[0], &hcal.flag[0],
+			&towerData[0], &regionData[0], &summaries[0])) {
+      cerr << "testUCTCInterface: Processing failed after " << nEvents << " events" << endl;
+      return 1;
+    }
+    elapsed += UCTMetrics::now() - start;
+    nEvents += nBatch;
+  }
+  uctDestroy(uct);
+
+  if(nEvents == 0) {
+    cerr << "testUCTCInterface: No events in " << argv[1] << endl;
+    return 1;
+  }
+  cout << "testUCTCInterface: " << nEvents << " events; " << fixed << setprecision(1)
+       << 1.e-3 * elapsed / nEvents << " us/event" << endl;
+  return 0;
+
+}
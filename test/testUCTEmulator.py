@@ -0,0 +1,58 @@
+#!/usr/bin/env python
+# Batch emulation from Python on pseudo random TPs
+# Checks the outputs against the inputs and prints the throughput
+# The TPs can be saved to tpFile, for timing the same batches with the
+# native driver testUCTCInterface
+# Usage: python testUCTEmulator.py [nEvents] [batchSize] [library] [tpFile]
+
+from __future__ import print_function
+
+import sys
+import time
+import numpy as np
+
+from L1Trigger.L1TCaloLayer1.uctEmulator import UCTEmulator, towerETMask, regionETMask
+
+nEvents = int(sys.argv[1]) if len(sys.argv) > 1 else 10000
+batchSize = int(sys.argv[2]) if len(sys.argv) > 2 else 1000
+emu = UCTEmulator(*sys.argv[3:4])
+tpFile = open(sys.argv[4], 'wb') if len(sys.argv) > 4 else None
+
+rng = np.random.RandomState(1)
+central = (np.abs(emu.towerCaloEta) <= 28)
+
+def makeTPs(nBatch, nTPs):
+    # nTPs distinct central towers per event
+    offsets = np.arange(nBatch + 1, dtype=np.uint32) * nTPs
+    towers = np.concatenate([rng.choice(np.flatnonzero(central), nTPs, replace=False) for e in range(nBatch)])
+    et = rng.randint(0, 256, size=len(towers)).astype(np.uint32)
+    flag = rng.randint(0, 2, size=len(towers)).astype(np.uint32)
+    return (offsets, emu.towerCaloEta[towers], emu.towerCaloPhi[towers], et, flag), towers
+
+out = emu.allocate(batchSize)
+elapsed = 0.
+for first in range(0, nEvents, batchSize):
+    nBatch = min(batchSize, nEvents - first)
+    ecal, ecalTowers = makeTPs(nBatch, 100)
+    hcal, hcalTowers = makeTPs(nBatch, 100)
+    if tpFile is not None:
+        # Batch header (nEvents, nECALTPs, nHCALTPs), then the arrays
+        np.array([nBatch, len(ecal[1]), len(hcal[1])], dtype=np.uint32).tofile(tpFile)
+        for a in ecal + hcal:
+            a.tofile(tpFile)
+    start = time.time()
+    towers, regions, summaries = emu.process(ecal, hcal, out)
+    elapsed += time.time() - start
+    # Tower ET is the saturated ECAL + HCAL ET, the summary the sum of the region ETs
+    expected = np.zeros(towers.shape, dtype=np.uint32)
+    rows = np.repeat(np.arange(nBatch), 100)
+    np.add.at(expected, (rows, ecalTowers), ecal[3])
+    np.add.at(expected, (rows, hcalTowers), hcal[3])
+    if not np.array_equal(towers & towerETMask, np.minimum(expected, towerETMask)):
+        sys.exit('testUCTEmulator: Tower ET mismatch')
+    if not np.array_equal((regions & regionETMask).sum(axis=1), summaries):
+        sys.exit('testUCTEmulator: Summary ET mismatch')
+
+if tpFile is not None:
+    tpFile.close()
+print('testUCTEmulator: %d events in batches of %d; %.1f us/event' % (nEvents, batchSize, 1.e6 * elapsed / nEvents))
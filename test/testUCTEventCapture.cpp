@@ -0,0 +1,171 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <set>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+using namespace std;
+
+#include "L1Trigger/L1TCaloLayer1/src/UCTLayer1.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTCrate.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTCard.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTRegion.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTTower.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTEventCapture.hh"
+
+// Writes pseudo random events to a capture file, reads them back and
+// replays them, and checks that corrupt and truncated files are rejected
+// cleanly
+
+// Random TPs on distinct central towers, loaded into the emulator one by
+// one as in the producer and packed for the capture
+
+void makeTPs(UCTLayer1& uct, bool ecal, uint32_t nTPs, vector<uint32_t>& words) {
+  set<pair<int, int> > used;
+  words.clear();
+  while(words.size() < nTPs) {
+    int caloEta = (random() % 28) + 1;
+    if((random() & 0x1) != 0) caloEta = -caloEta;
+    int caloPhi = (random() % 72) + 1;
+    if(!used.insert(make_pair(caloEta, caloPhi)).second) continue;
+    uint32_t et = (random() % 255) + 1;
+    uint32_t flag = (ecal ? (random() & 0x1) : (random() & 0x1F));
+    bool ok = (ecal ?
+	       uct.setECALData(UCTTowerIndex(caloEta, caloPhi), flag, et) :
+	       uct.setHCALData(UCTTowerIndex(caloEta, caloPhi), et, flag));
+    if(!ok) {
+      cerr << "testUCTEventCapture: Failed loading a TP" << endl;
+      exit(1);
+    }
+    words.push_back(UCTCaptureEvent::packTP(caloEta, caloPhi, et, flag));
+  }
+}
+
+void getTowers(UCTLayer1& uct, vector<uint32_t>& words) {
+  words.clear();
+  const UCTCrateList& crates = uct.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  const UCTTower* t = towers[twr];
+	  uint32_t word = UCTCaptureEvent::packTower(t->caloEta(), t->caloPhi(), t->et(), t->er(), t->miscBits());
+	  if(!UCTCaptureEvent::isEmptyTower(word)) words.push_back(word);
+	}
+      }
+    }
+  }
+}
+
+bool same(const UCTCaptureEvent& a, const UCTCaptureEvent& b) {
+  return (a.run == b.run && a.lumi == b.lumi && a.event == b.event && a.bx == b.bx &&
+	  a.ecalTPs == b.ecalTPs && a.hcalTPs == b.hcalTPs &&
+	  a.testTowers == b.testTowers && a.emulTowers == b.emulTowers);
+}
+
+// Number of events read before the first failure
+
+uint32_t readAll(const string& fileName) {
+  UCTEventCapture capture;
+  if(!capture.openForRead(fileName)) return 0;
+  UCTCaptureEvent event;
+  while(capture.read(event)) {;}
+  return capture.getNEvents();
+}
+
+int main(int argc, char** argv) {
+
+  string fileName = "testUCTEventCapture.dat";
+  uint32_t nEvents = 20;
+  if(argc > 1) fileName = argv[1];
+  if(argc > 2) {
+    cout << "Command syntax: testUCTEventCapture [captureFile]" << endl;
+    return 1;
+  }
+
+  // Write; odd events get a test tower that differs from the emulator, and
+  // every fourth is a crossing other than the triggered one, without TPs
+
+  UCTLayer1 uct;
+  vector<UCTCaptureEvent> events(nEvents);
+  UCTEventCapture capture;
+  if(!capture.openForWrite(fileName)) return 1;
+  for(uint32_t e = 0; e < nEvents; e++) {
+    UCTCaptureEvent& event = events[e];
+    event.clear();
+    event.run = 1000 + e / 10;
+    event.lumi = e;
+    event.event = (((uint64_t) 1) << 33) + e;
+    event.bx = ((e % 4) == 3 ? -2 : 0);
+    if(!uct.clearEvent()) return 1;
+    makeTPs(uct, true, 50 + (random() % 100), event.ecalTPs);
+    makeTPs(uct, false, 50 + (random() % 100), event.hcalTPs);
+    if(!uct.process()) return 1;
+    getTowers(uct, event.emulTowers);
+    event.testTowers = event.emulTowers;
+    if((e % 2) != 0) event.testTowers[0] ^= 0x1;
+    if(event.bx != 0) {
+      event.ecalTPs.clear();
+      event.hcalTPs.clear();
+    }
+    if(!capture.write(event)) return 1;
+  }
+  capture.close();
+
+  // Read back and replay
+
+  if(!capture.openForRead(fileName)) return 1;
+  UCTCaptureEvent event;
+  vector<uint32_t> replayed;
+  for(uint32_t e = 0; e < nEvents; e++) {
+    if(!capture.read(event) || !same(event, events[e])) {
+      cerr << "testUCTEventCapture: Event " << e << " does not read back as written" << endl;
+      return 1;
+    }
+    if(event.bx != 0) continue;
+    if(!UCTEventCapture::replay(uct, event, replayed) || replayed != event.emulTowers) {
+      cerr << "testUCTEventCapture: Event " << e << " does not replay to the captured emulator towers" << endl;
+      return 1;
+    }
+  }
+  if(capture.read(event) || capture.getNEvents() != nEvents) {
+    cerr << "testUCTEventCapture: Wrong number of events in " << fileName << endl;
+    return 1;
+  }
+  capture.close();
+
+  // A huge count in the second record, then a file cut in the last record
+
+  ifstream in(fileName.c_str(), ios::binary);
+  vector<char> bytes((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+  in.close();
+  size_t secondRecord = (2 + 9 + events[0].ecalTPs.size() + events[0].hcalTPs.size() +
+			 events[0].testTowers.size() + events[0].emulTowers.size()) * sizeof(uint32_t);
+  vector<char> corrupt(bytes);
+  ((uint32_t*) &corrupt[secondRecord])[5] = 0x40000000;
+  ofstream out(fileName.c_str(), ios::binary | ios::trunc);
+  out.write(&corrupt[0], corrupt.size());
+  out.close();
+  if(readAll(fileName) != 1) {
+    cerr << "testUCTEventCapture: A record with a huge count was not rejected" << endl;
+    return 1;
+  }
+  out.open(fileName.c_str(), ios::binary | ios::trunc);
+  out.write(&bytes[0], bytes.size() - sizeof(uint32_t));
+  out.close();
+  if(readAll(fileName) != nEvents - 1) {
+    cerr << "testUCTEventCapture: A truncated record was not rejected" << endl;
+    return 1;
+  }
+  remove(fileName.c_str());
+
+  cout << "testUCTEventCapture: " << nEvents << " events written, read back and replayed" << endl;
+  return 0;
+
+}
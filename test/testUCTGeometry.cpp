@@ -1,6 +1,7 @@
 #include <iostream>
 #include <stdlib.h>
 #include <stdint.h>
+#include <set>
 
 using namespace std;
 
@@ -8,6 +9,7 @@ using namespace std;
 
 int main(int argc, char** argv) {
   UCTGeometry g;
+  std::set<uint32_t> usedLinkChannels;
   for(int caloPhi = 1; caloPhi <= MaxCaloPhi; caloPhi++) {
     for(int caloEta = -MaxCaloEta; caloEta <= MaxCaloEta; caloEta++) {
       if(caloEta == 0 || abs(caloEta) == 29) continue;
@@ -27,6 +29,15 @@ int main(int argc, char** argv) {
 	cerr << "(caloEta, caloPhi) = (" << cEta << ", " << cPhi << ") " 
 	     << "Obtained instead   " << endl;
       }
+      uint32_t link = g.getLinkNumber((caloEta < 0), rgn, eta, phi);
+      uint32_t channel = g.getChannelNumber(rgn, eta, phi);
+      uint32_t linkChannel = ((crt * NCardsInCrate + crd) * NLinksInCard + link) * NChannelsInLink + channel;
+      if(link >= NLinksInCard || channel >= NChannelsInLink || 
+	 !usedLinkChannels.insert(linkChannel).second) {
+	cerr << "(caloEta, caloPhi) = (" << caloEta << ", " << caloPhi << ") "
+	     << "has invalid or duplicate (link, channel) = (" 
+	     << link << ", " << channel << ")" << endl;
+      }
       double realEta = g.getUCTTowerEta(caloEta);
       double realPhi = g.getUCTTowerPhi(caloPhi, caloEta);
       cout << "(caloEta, caloPhi) = (" << caloEta << ", " << caloPhi << ") ;" 
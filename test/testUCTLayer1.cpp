@@ -1,6 +1,9 @@
 #include <iostream>
 #include <iomanip>
+#include <fstream>
 #include <vector>
+#include <algorithm>
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <math.h>
@@ -15,6 +18,17 @@ using namespace std;
 
 #include "L1Trigger/L1TCaloLayer1/src/UCTGeometry.hh"
 
+#include "L1Trigger/L1TCaloLayer1/src/UCTLinkUnpacker.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTGlobalSums.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTTowerSumTable.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTPileupEstimator.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTTowerHistory.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTChannelMask.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTCalibrationLUT.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTThresholdScan.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTRegionCounters.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTRegionVeto.hh"
+
 double flatRandom(double min, double max) {
   static double rMax = (double) 0x7FFFFFFF;
   uint32_t r = random();
@@ -51,16 +65,16 @@ double poissonRandom(double mean) {
 }
 
 void print(UCTLayer1& uct) {
-  vector<UCTCrate*> crates = uct.getCrates();
+  const UCTCrateList& crates = uct.getCrates();
   for(uint32_t crt = 0; crt < crates.size(); crt++) {
-    vector<UCTCard*> cards = crates[crt]->getCards();
+    const UCTCardList& cards = crates[crt]->getCards();
     for(uint32_t crd = 0; crd < cards.size(); crd++) {
-      vector<UCTRegion*> regions = cards[crd]->getRegions();
+      const UCTRegionList& regions = cards[crd]->getRegions();
       for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
 	if(regions[rgn]->et() > 0) {
 	  int hitEta = regions[rgn]->hitCaloEta();
 	  int hitPhi = regions[rgn]->hitCaloPhi();
-	  vector<UCTTower*> towers = regions[rgn]->getTowers();
+	  const UCTTowerList& towers = regions[rgn]->getTowers();
 	  bool header = true;
 	  for(uint32_t twr = 0; twr < towers.size(); twr++) {
 	    if(towers[twr]->caloPhi() == hitPhi && towers[twr]->caloEta() == hitEta) {
@@ -79,6 +93,545 @@ void print(UCTLayer1& uct) {
   uct.print();
 }
 
+bool checkSnapshot(UCTLayer1& uct) {
+  // Snapshot, restore into a fresh instance and compare with a clone
+  std::vector<uint8_t> buffer(uct.snapshotSize());
+  if(uct.snapshot(&buffer[0], buffer.size()) != buffer.size()) return false;
+  UCTLayer1 restored;
+  if(!restored.restore(&buffer[0], buffer.size())) return false;
+  UCTLayer1* cloned = uct.clone();
+  std::vector<uint8_t> restoredBuffer(buffer.size());
+  std::vector<uint8_t> clonedBuffer(buffer.size());
+  restored.snapshot(&restoredBuffer[0], restoredBuffer.size());
+  cloned->snapshot(&clonedBuffer[0], clonedBuffer.size());
+  delete cloned;
+  return (buffer == restoredBuffer && buffer == clonedBuffer && restored.et() == uct.et());
+}
+
+bool checkCrateProcessing(UCTLayer1& uct) {
+  // Processing crate by crate goes through the region shape kernels
+  // dispatched by the cards and must reproduce the layer processing
+  std::vector<uint8_t> buffer(uct.snapshotSize());
+  std::vector<uint8_t> crateBuffer(buffer.size());
+  uct.snapshot(&buffer[0], buffer.size());
+  UCTLayer1* cloned = uct.clone();
+  const UCTCrateList& crates = cloned->getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    if(!crates[crt]->process()) return false;
+  }
+  cloned->snapshot(&crateBuffer[0], crateBuffer.size());
+  delete cloned;
+  // The header holds the layer summary, which is not recomputed here
+  size_t header = UCTLayer1::snapshotHeaderWords * sizeof(uint32_t);
+  return std::equal(buffer.begin() + header, buffer.end(), crateBuffer.begin() + header);
+}
+
+bool checkLinkUnpacker(UCTLayer1& uct) {
+  // Build the input links from the towers and replay them into a fresh instance
+  UCTGeometry g;
+  std::vector<uint16_t> inputLinks(UCTLinkUnpacker::size(), 0);
+  const UCTCrateList& crates = uct.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      uint16_t* ecalLinks = &inputLinks[(crt * NCardsInCrate + crd) * NInputWordsInCard];
+      uint16_t* hcalLinks = ecalLinks + NTowerWordsInCard;
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  const UCTTower* t = towers[twr];
+	  uint32_t word = 
+	    g.getLinkNumber(t->isNegativeEta(), t->getRegion(), t->getiEta(), t->getiPhi()) * NChannelsInLink +
+	    g.getChannelNumber(t->getRegion(), t->getiEta(), t->getiPhi());
+	  uint32_t input = t->inputData();
+	  ecalLinks[word] = (input & 0xFF) | (((input >> 22) & 0x1) << 8);
+	  hcalLinks[word] = ((input >> 8) & 0xFF) | (((input >> 16) & 0x3F) << 8);
+	}
+      }
+    }
+  }
+  UCTLayer1 replayed;
+  UCTLinkUnpacker unpacker(replayed);
+  if(!unpacker.unpack(&inputLinks[0], inputLinks.size())) return false;
+  if(!replayed.process()) return false;
+  std::vector<uint8_t> buffer(uct.snapshotSize());
+  std::vector<uint8_t> replayedBuffer(buffer.size());
+  uct.snapshot(&buffer[0], buffer.size());
+  replayed.snapshot(&replayedBuffer[0], replayedBuffer.size());
+  return (buffer == replayedBuffer);
+}
+
+bool checkBulkTPs(UCTLayer1& uct, 
+		  std::vector<int> ecalTPs[4], std::vector<int> hcalTPs[4]) {
+  // Load the same TPs through the bulk setters into a fresh instance
+  UCTLayer1 bulk;
+  std::vector<uint32_t> ecalET(ecalTPs[2].begin(), ecalTPs[2].end());
+  std::vector<uint32_t> ecalFG(ecalTPs[3].begin(), ecalTPs[3].end());
+  std::vector<uint32_t> hcalET(hcalTPs[2].begin(), hcalTPs[2].end());
+  std::vector<uint32_t> hcalFB(hcalTPs[3].begin(), hcalTPs[3].end());
+  if(ecalET.size() > 0 &&
+     !bulk.setECALData(&ecalTPs[0][0], &ecalTPs[1][0], &ecalET[0], &ecalFG[0], ecalET.size())) return false;
+  if(hcalET.size() > 0 &&
+     !bulk.setHCALData(&hcalTPs[0][0], &hcalTPs[1][0], &hcalET[0], &hcalFB[0], hcalET.size())) return false;
+  if(!bulk.process()) return false;
+  std::vector<uint8_t> buffer(uct.snapshotSize());
+  std::vector<uint8_t> bulkBuffer(buffer.size());
+  uct.snapshot(&buffer[0], buffer.size());
+  bulk.snapshot(&bulkBuffer[0], bulkBuffer.size());
+  return (buffer == bulkBuffer);
+}
+
+bool checkEtSums(const UCTEtSums& s, uint32_t et, uint32_t ht, double x, double y, double hx, double hy) {
+  // Vector components are compared in ET units, within the rounding of the
+  // fixed-point tables, and the angles to within a caloPhi bin
+  const double scale = 1 << GlobalSumTrigBits;
+  double tolerance = 0.001 * et + 1;
+  if(s.et != et || s.ht != ht) return false;
+  if(fabs(s.metX / scale - x) > tolerance || fabs(s.metY / scale - y) > tolerance) return false;
+  if(fabs(s.mhtX / scale - hx) > tolerance || fabs(s.mhtY / scale - hy) > tolerance) return false;
+  double met = sqrt(x * x + y * y);
+  double mht = sqrt(hx * hx + hy * hy);
+  if(fabs(s.met - met) > tolerance + 1 || fabs(s.mht - mht) > tolerance + 1) return false;
+  double phi[2] = {atan2(y, x), atan2(hy, hx)};
+  uint32_t sumPhi[2] = {s.metPhi, s.mhtPhi};
+  double magnitude[2] = {met, mht};
+  for(uint32_t i = 0; i < 2; i++) {
+    if(magnitude[i] < 100 * tolerance) continue;
+    if(phi[i] < 0) phi[i] += 2. * M_PI;
+    int bin = ((int) (phi[i] * MaxCaloPhi / (2. * M_PI))) % MaxCaloPhi + 1;
+    int dBin = abs(bin - (int) sumPhi[i]);
+    if(dBin > 1 && dBin < MaxCaloPhi - 1) return false;
+  }
+  return true;
+}
+
+bool checkGlobalSums(UCTLayer1& uct, UCTGlobalSums& sums, 
+		     uint32_t towerHTThreshold = 0, uint32_t regionHTThreshold = 0) {
+  // Compare the fixed-point sums with floating-point sums over the towers
+  // and over the regions, at their own phi segmentations
+  if(!sums.process()) return false;
+  uint32_t et = 0;
+  uint32_t ht = 0;
+  double x = 0;
+  double y = 0;
+  double hx = 0;
+  double hy = 0;
+  uint32_t regionET = 0;
+  uint32_t regionHT = 0;
+  double regionX = 0;
+  double regionY = 0;
+  double regionHX = 0;
+  double regionHY = 0;
+  const UCTCrateList& crates = uct.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  double phi = (towers[twr]->caloPhi() - 0.5) * 2. * M_PI / MaxCaloPhi;
+	  if(regions[rgn]->getRegion() >= CaloVHFRegionStart) phi = towers[twr]->caloPhi() * 2. * M_PI / (MaxCaloPhiInVHF);
+	  else if(regions[rgn]->getRegion() >= CaloHFRegionStart) phi = (towers[twr]->caloPhi() - 0.5) * 2. * M_PI / (MaxCaloPhiInHF);
+	  uint32_t e = towers[twr]->et();
+	  et += e;
+	  x -= e * cos(phi);
+	  y -= e * sin(phi);
+	  if(e > towerHTThreshold) {
+	    ht += e;
+	    hx -= e * cos(phi);
+	    hy -= e * sin(phi);
+	  }
+	}
+	double phi = regions[rgn]->regionIndex().second * 2. * M_PI / (MaxUCTRegionsPhi);
+	uint32_t e = regions[rgn]->et();
+	regionET += e;
+	regionX -= e * cos(phi);
+	regionY -= e * sin(phi);
+	if(e > regionHTThreshold) {
+	  regionHT += e;
+	  regionHX -= e * cos(phi);
+	  regionHY -= e * sin(phi);
+	}
+      }
+    }
+  }
+  if(regionET != uct.et()) return false;
+  return (checkEtSums(sums.getTowerSums(), et, ht, x, y, hx, hy) &&
+	  checkEtSums(sums.getRegionSums(), regionET, regionHT, regionX, regionY, regionHX, regionHY));
+}
+
+bool checkForwardGlobalSums(UCTLayer1& uct) {
+  // Add HF and VHF deposits to a copy of the event and check the sums
+  // with HT thresholds, so that all row segmentations are summed
+  UCTLayer1* forward = uct.clone();
+  const UCTCrateList& crates = forward->getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	if(regions[rgn]->getRegion() < CaloHFRegionStart) continue;
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  if((random() % 4) != 0) continue;
+	  if(!towers[twr]->setHCALData((random() & 0xFF), 0)) return false;
+	}
+      }
+    }
+  }
+  UCTGlobalSums sums(*forward, 20, 50);
+  bool ok = (forward->process() && checkGlobalSums(*forward, sums, 20, 50));
+  delete forward;
+  return ok;
+}
+
+bool checkThresholdScan(UCTLayer1& uct, UCTThresholdScan& scan) {
+  // The first configuration is the default one and must count the regions
+  // without veto bits in the emulator output; the second is looser and the
+  // third tighter, so they count at least as many and at most as many
+  if(!scan.scan()) return false;
+  uint32_t nEG = 0;
+  uint32_t nTau = 0;
+  const UCTCrateList& crates = uct.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	if(regions[rgn]->getRegion() >= NRegionsInCard || regions[rgn]->et() == 0) continue;
+	if((regions[rgn]->rawData() & RegionEGVeto) == 0) nEG++;
+	if((regions[rgn]->rawData() & RegionTauVeto) == 0) nTau++;
+      }
+    }
+  }
+  const std::vector<uint32_t>& eg = scan.getEventEGCounts();
+  const std::vector<uint32_t>& tau = scan.getEventTauCounts();
+  return (eg[0] == nEG && tau[0] == nTau &&
+	  eg[1] >= eg[0] && eg[0] >= eg[2] && tau[1] >= tau[0] && tau[0] >= tau[2]);
+}
+
+bool checkTowerSumTable(UCTLayer1& uct) {
+  // Compare random central windows with tower by tower sums
+  const UCTTowerSumTable* table = uct.getTowerSumTable();
+  if(table == 0) return false;
+  for(uint32_t i = 0; i < 100; i++) {
+    int caloEta = (random() % 41) - 20;
+    if(caloEta == 0) caloEta = 1;
+    int caloPhi = (random() % MaxCaloPhi) + 1;
+    uint32_t halfEta = random() % 4;
+    uint32_t halfPhi = random() % 4;
+    uint32_t et = 0;
+    int eta = caloEta;
+    for(uint32_t n = 0; n < halfEta; n++) if(--eta == 0) eta--;
+    for(uint32_t n = 0; n < 2 * halfEta + 1; n++) {
+      for(int dPhi = -((int) halfPhi); dPhi <= (int) halfPhi; dPhi++) {
+	int phi = (caloPhi - 1 + dPhi + MaxCaloPhi) % MaxCaloPhi + 1;
+	et += uct.getTower(UCTTowerIndex(eta, phi))->et();
+      }
+      if(++eta == 0) eta++;
+    }
+    if(table->getWindowET(caloEta, caloPhi, halfEta, halfPhi) != et) return false;
+  }
+  return (table->getET(-MaxCaloEta, MaxCaloEta, 1, MaxCaloPhi) == table->getWindowET(1, 1, 100, 100));
+}
+
+// Floating-point running averages of the ring ETs, as a reference for UCTPileupEstimator
+
+struct PileupReference {
+  PileupReference() : towers(2 * MaxCaloEta + 1, 0.), regions(MaxUCTRegionsEta + 1, 0.), nEvents(0) {;}
+  std::vector<double> towers;
+  std::vector<double> regions;
+  uint32_t nEvents;
+};
+
+void updatePileupReference(UCTLayer1& uct, PileupReference& reference, uint32_t averageShift) {
+  double weight = (reference.nEvents == 0 ? 1. : 1. / (1 << averageShift));
+  for(int caloEta = -MaxCaloEta; caloEta <= MaxCaloEta; caloEta++) {
+    double& average = reference.towers[caloEta + MaxCaloEta];
+    average += (uct.getTowerRingET(caloEta) - average) * weight;
+  }
+  for(int regionEta = -MaxUCTRegionsEta / 2; regionEta <= MaxUCTRegionsEta / 2; regionEta++) {
+    if(regionEta == 0) continue;
+    double& average = reference.regions[regionEta + MaxUCTRegionsEta / 2];
+    average += (uct.getRegionRingET(regionEta) - average) * weight;
+  }
+  reference.nEvents++;
+}
+
+bool checkRingSums(UCTLayer1& uct, UCTPileupEstimator& pileup, PileupReference& reference) {
+  // Ring sums add up to the total, and the running averages follow the
+  // reference; the fixed-point update truncates by less than 2^-PileupFractionBits
+  // per event, which adds up to at most 2^(averageShift - PileupFractionBits)
+  uint32_t towerET = 0;
+  uint32_t regionET = 0;
+  for(int caloEta = -MaxCaloEta; caloEta <= MaxCaloEta; caloEta++) {
+    towerET += uct.getTowerRingET(caloEta);
+  }
+  for(int regionEta = -13; regionEta <= 13; regionEta++) {
+    regionET += uct.getRegionRingET(regionEta);
+  }
+  const UCTTowerSumTable* table = uct.getTowerSumTable();
+  if(towerET != table->getET(-MaxCaloEta, MaxCaloEta, 1, MaxCaloPhi) || regionET != uct.et()) return false;
+  if(pileup.getNEvents() != reference.nEvents) return false;
+  double tolerance = ((double) (1 << pileup.getAverageShift())) / (1 << PileupFractionBits) + 0.01;
+  for(int caloEta = -MaxCaloEta; caloEta <= MaxCaloEta; caloEta++) {
+    if(fabs(pileup.getTowerRingPileup(caloEta) - reference.towers[caloEta + MaxCaloEta]) > tolerance) return false;
+  }
+  for(int regionEta = -MaxUCTRegionsEta / 2; regionEta <= MaxUCTRegionsEta / 2; regionEta++) {
+    if(regionEta == 0) continue;
+    if(fabs(pileup.getRegionRingPileup(regionEta) - reference.regions[regionEta + MaxUCTRegionsEta / 2]) > tolerance) return false;
+  }
+  return true;
+}
+
+bool checkTowerHistory(UCTLayer1& uct, UCTTowerHistory& history, std::vector<uint32_t>& previousET) {
+  // The latest crossing matches the towers and the one before the saved ETs
+  bool ok = history.record();
+  std::vector<uint32_t> currentET(history.getNTowers(), 0);
+  const UCTCrateList& crates = uct.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  uint32_t i = history.getIndex(towers[twr]);
+	  currentET[i] = towers[twr]->et();
+	  if(history.getET(i, 0) != currentET[i] || history.getData(i, 0) != towers[twr]->rawData()) ok = false;
+	  if(history.getET(i, 1) != previousET[i]) ok = false;
+	  if(history.getSumET(i, 2) != currentET[i] + previousET[i]) ok = false;
+	}
+      }
+    }
+  }
+  previousET.swap(currentET);
+  return ok;
+}
+
+bool checkDeltaProcessing(UCTLayer1& uct, UCTLayer1& delta,
+			  std::vector<int> ecalTPs[4], std::vector<int> hcalTPs[4]) {
+  // Stream this crossing, the same with its first ECAL TP removed, and this
+  // crossing again; the delta instance checks itself against full
+  // reprocessing, and has to end up in the state of the reference
+  for(uint32_t pass = 0; pass < 3; pass++) {
+    if(!delta.clearEvent()) return false;
+    for(uint32_t i = (pass == 1 ? 1 : 0); i < ecalTPs[0].size(); i++) {
+      if(!delta.setECALData(UCTTowerIndex(ecalTPs[0][i], ecalTPs[1][i]), ecalTPs[3][i], ecalTPs[2][i])) return false;
+    }
+    for(uint32_t i = 0; i < hcalTPs[0].size(); i++) {
+      if(!delta.setHCALData(UCTTowerIndex(hcalTPs[0][i], hcalTPs[1][i]), hcalTPs[2][i], hcalTPs[3][i])) return false;
+    }
+    if(!delta.process()) return false;
+  }
+  std::vector<uint8_t> buffer(uct.snapshotSize());
+  std::vector<uint8_t> deltaBuffer(buffer.size());
+  uct.snapshot(&buffer[0], buffer.size());
+  delta.snapshot(&deltaBuffer[0], deltaBuffer.size());
+  return (buffer == deltaBuffer);
+}
+
+bool checkChannelMask(UCTLayer1& uct, std::vector<int> ecalTPs[4]) {
+  // Mask the ECAL of the first hit towers; they lose their ECAL energy,
+  // which is counted, and all other towers are unchanged
+  UCTChannelMask mask;
+  for(uint32_t i = 0; i < ecalTPs[0].size() && i < 3; i++) {
+    if(!mask.setMask(ecalTPs[0][i], ecalTPs[1][i], true, false)) return false;
+  }
+  UCTLayer1* masked = uct.clone();
+  if(!masked->setChannelMask(&mask) || !masked->process()) return false;
+  bool ok = true;
+  uint32_t maskedET = 0;
+  const UCTCrateList& crates = uct.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  const UCTTower* t = towers[twr];
+	  const UCTTower* m = masked->getTower(t->towerIndex());
+	  if(mask.isECALMasked(t->caloEta(), t->caloPhi())) {
+	    maskedET += (t->inputData() & 0xFF);
+	    if(m->getEcalET() != 0 || m->getHcalET() != t->getHcalET()) ok = false;
+	  }
+	  else if(m->rawData() != t->rawData()) ok = false;
+	}
+      }
+    }
+  }
+  if(masked->getMaskedECALET() != maskedET || masked->getMaskedHCALET() != 0) ok = false;
+  delete masked;
+  return ok;
+}
+
+bool checkRegionVeto(UCTLayer1& uct) {
+  // Layer-wide veto bits must match the per-region computation
+  const UCTCrateList& crates = uct.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	if(regions[rgn]->getRegion() >= NRegionsInCard) continue;
+	uint32_t vetoBits = 0;
+	if(!regions[rgn]->computeVetoBits(&UCTRegion::getDefaultThresholds(), 1, &vetoBits)) return false;
+	if((regions[rgn]->rawData() & (RegionEGVeto | RegionTauVeto)) != vetoBits) return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool checkCalibrationLUT(UCTLayer1& uct) {
+  // Write a LUT set, reload it and check the calibrated towers; files with
+  // a corrupted header or payload must be rejected
+  std::string fileName = "testUCTLayer1.lut";
+  std::vector<uint8_t> tables(NLUTWords);
+  for(uint32_t i = 0; i < NLUTWords; i++) {
+    uint32_t et = i % NLUTEntries;
+    tables[i] = (i < NLUTWords / 2) ? std::min(2 * et, (uint32_t) 0xFF) : et / 2;
+  }
+  UCTCalibrationLUT lut;
+  if(!UCTCalibrationLUT::write(fileName, 7, tables) || !lut.load(fileName) || lut.getVersion() != 7) return false;
+  UCTLayer1* calibrated = uct.clone();
+  if(!calibrated->setCalibrationLUT(&lut) || !calibrated->process()) return false;
+  bool ok = true;
+  const UCTCrateList& crates = uct.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	const UCTTowerList& towers = regions[rgn]->getTowers();
+	for(uint32_t twr = 0; twr < towers.size(); twr++) {
+	  const UCTTower* t = towers[twr];
+	  const UCTTower* c = calibrated->getTower(t->towerIndex());
+	  uint32_t ecalET = (t->inputData() & 0xFF);
+	  uint32_t hcalET = ((t->inputData() >> 8) & 0xFF);
+	  // HF towers have no ECAL table
+	  if(t->getRegion() < NRegionsInCard) ecalET = lut.getECALLUT(t->caloEta(), t->caloPhi())[ecalET];
+	  hcalET = lut.getHCALLUT(t->caloEta(), t->caloPhi())[hcalET];
+	  if(c->getEcalET() != ecalET || c->getHcalET() != hcalET ||
+	     c->et() != std::min(ecalET + hcalET, (uint32_t) etMask)) ok = false;
+	}
+      }
+    }
+  }
+  delete calibrated;
+  lut.unload();
+  // Corrupt the number of entries in the header, then one payload byte
+  std::vector<char> file(UCTCalibrationLUT::headerWords * sizeof(uint32_t) + NLUTWords);
+  std::ifstream in(fileName.c_str(), std::ios::binary);
+  if(!in.read(&file[0], file.size())) ok = false;
+  in.close();
+  for(uint32_t pass = 0; pass < 2; pass++) {
+    std::vector<char> corrupted(file);
+    if(pass == 0) ((uint32_t*) &corrupted[0])[5]++;
+    else corrupted[UCTCalibrationLUT::headerWords * sizeof(uint32_t) + 12345] ^= 0x1;
+    std::ofstream out(fileName.c_str(), std::ios::binary);
+    out.write(&corrupted[0], corrupted.size());
+    out.close();
+    if(lut.load(fileName)) ok = false;
+  }
+  remove(fileName.c_str());
+  return ok;
+}
+
+bool checkRegionVetoPatterns() {
+  // The word-wide pattern veto on all pairs of 4-bit eta and phi patterns,
+  // 64 pairs per word, against the list of bad patterns of UCTRegion
+  // (0101, 0111, 1001, 1010, 1011, 1101, 1110 and 1111)
+  bool badPattern[16] = {false, false, false, false, false, true, false, true,
+			 false, true, true, true, false, true, true, true};
+  for(uint32_t w = 0; w < 4; w++) {
+    uint64_t etaPattern[4] = {0, 0, 0, 0};
+    uint64_t phiPattern[4] = {0, 0, 0, 0};
+    for(uint32_t i = 0; i < 64; i++) {
+      uint32_t eta = (w * 64 + i) / 16;
+      uint32_t phi = (w * 64 + i) % 16;
+      for(uint32_t b = 0; b < 4; b++) {
+	if(((eta >> b) & 0x1) != 0) etaPattern[b] |= (((uint64_t) 1) << i);
+	if(((phi >> b) & 0x1) != 0) phiPattern[b] |= (((uint64_t) 1) << i);
+      }
+    }
+    uint64_t veto = UCTRegionVeto::patternVeto(etaPattern, phiPattern);
+    for(uint32_t i = 0; i < 64; i++) {
+      uint32_t eta = (w * 64 + i) / 16;
+      uint32_t phi = (w * 64 + i) % 16;
+      if((((veto >> i) & 0x1) != 0) != (badPattern[eta] || badPattern[phi])) return false;
+    }
+  }
+  return true;
+}
+
+bool checkRegionCounters() {
+  // Give the central regions ETs on both sides of the bin edges, in turn,
+  // and check the per bin counts, and their run and job sums over a run
+  // boundary
+  const uint32_t nETs = 12;
+  uint32_t ets[nETs] = {1, 2, 3, 4, 7, 8, 255, 256, 511, 512, 1023, 2000};
+  uint32_t bins[nETs] = {0, 1, 1, 2, 2, 3, 7, 8, 8, 9, 9, 9};
+  UCTLayer1 uct;
+  std::vector<uint32_t> expected(NRegionEtaRings * NRegionETBins, 0);
+  uint32_t n = 0;
+  const UCTCrateList& crates = uct.getCrates();
+  for(uint32_t crt = 0; crt < crates.size(); crt++) {
+    const UCTCardList& cards = crates[crt]->getCards();
+    for(uint32_t crd = 0; crd < cards.size(); crd++) {
+      const UCTRegionList& regions = cards[crd]->getRegions();
+      for(uint32_t rgn = 0; rgn < regions.size(); rgn++) {
+	UCTRegion* region = regions[rgn];
+	if(region->getRegion() >= NRegionsInCard) continue;
+	uint32_t et = ets[n % nETs];
+	uint32_t ring = UCTRegionCounters::getRing(region->isNegativeEta(), region->getRegion());
+	expected[ring * NRegionETBins + bins[n % nETs]]++;
+	n++;
+	const UCTTowerList& towers = region->getTowers();
+	for(uint32_t twr = 0; twr < towers.size() && et > 0; twr++) {
+	  uint32_t ecalET = std::min(et, (uint32_t) 0xFF);
+	  uint32_t hcalET = std::min(et - ecalET, (uint32_t) 0xFF);
+	  et -= (ecalET + hcalET);
+	  if(!uct.setECALData(towers[twr]->towerIndex(), false, ecalET)) return false;
+	  if(hcalET > 0 && !uct.setHCALData(towers[twr]->towerIndex(), hcalET, 0)) return false;
+	}
+      }
+    }
+  }
+  if(!uct.process()) return false;
+  UCTRegionCounters counters(uct);
+  if(!counters.fill() || !counters.fill()) return false;
+  for(uint32_t pass = 0; pass < 2; pass++) {
+    // First after two events, then after one more in a new run
+    if(pass == 1) {
+      counters.beginRun();
+      if(counters.getNRunEvents() != 0 || counters.getNJobEvents() != 2) return false;
+      if(!counters.fill()) return false;
+    }
+    uint64_t nRun = (pass == 0 ? 2 : pass);
+    uint64_t nJob = pass + 2;
+    if(counters.getNRunEvents() != nRun || counters.getNJobEvents() != nJob) return false;
+    for(uint32_t ring = 0; ring < NRegionEtaRings; ring++) {
+      for(uint32_t bin = 0; bin < NRegionETBins; bin++) {
+	uint32_t all = expected[ring * NRegionETBins + bin];
+	if(counters.getEventCount(UCTRegionCounters::AllRegions, ring, bin) != all ||
+	   counters.getRunCount(UCTRegionCounters::AllRegions, ring, bin) != nRun * all ||
+	   counters.getJobCount(UCTRegionCounters::AllRegions, ring, bin) != nJob * all) return false;
+	for(uint32_t c = UCTRegionCounters::EGLikeRegions; c < UCTRegionCounters::NCounters; c++) {
+	  UCTRegionCounters::Counter counter = (UCTRegionCounters::Counter) c;
+	  uint32_t count = counters.getEventCount(counter, ring, bin);
+	  if(count > all || counters.getRunCount(counter, ring, bin) != nRun * count ||
+	     counters.getJobCount(counter, ring, bin) != nJob * count) return false;
+	}
+      }
+    }
+  }
+  return true;
+}
+
 int main(int argc, char** argv) {
 
   int nEvents = 10000;
@@ -87,6 +640,33 @@ int main(int argc, char** argv) {
   else {std::cout << "Command syntax: testUCTLayer1 [nEvents]" << std::endl; return 1;}
 
   UCTLayer1 uctLayer1;
+  UCTGlobalSums globalSums(uctLayer1);
+  uctLayer1.enableTowerSumTable(true);
+  UCTPileupEstimator pileupEstimator(uctLayer1);
+  PileupReference pileupReference;
+  UCTTowerHistory towerHistory(uctLayer1, 4);
+  std::vector<uint32_t> previousET(towerHistory.getNTowers(), 0);
+  UCTLayer1 deltaLayer1;
+  deltaLayer1.setDeltaMode(true, true);
+  // Default, looser and tighter EG and tau isolation
+  std::vector<UCTRegionThresholds> thresholds(3, UCTRegion::getDefaultThresholds());
+  thresholds[1].ecalActivityFraction *= 2;
+  thresholds[1].miscActivityFraction *= 2;
+  thresholds[2].ecalActivityFraction /= 2;
+  thresholds[2].miscActivityFraction /= 2;
+  UCTThresholdScan thresholdScan(uctLayer1, thresholds);
+
+  // Check the region veto pattern logic
+  if(!checkRegionVetoPatterns()) {
+    std::cerr << "UCT: Region veto pattern mismatch" << std::endl;
+    exit(1);
+  }
+
+  // Check the region counters on a fixed event
+  if(!checkRegionCounters()) {
+    std::cerr << "UCT: Region counter mismatch" << std::endl;
+    exit(1);
+  }
 
   // Event loop for test
   for(int event = 0; event < nEvents; event++) {
@@ -99,6 +679,10 @@ int main(int argc, char** argv) {
     // Put a random number of towers in the UCT 
 
     uint32_t expectedTotalET = 0;
+
+    // (caloEta, caloPhi, et, flag) of the TPs for the bulk setter check
+    std::vector<int> ecalTPs[4];
+    std::vector<int> hcalTPs[4];
     
     // ECAL TPGs - set a mean of 100 random ECAL towers!
     uint32_t nHitTowers = poissonRandom(100.);
@@ -110,11 +694,16 @@ int main(int argc, char** argv) {
       if((random() & 0x1) != 0) caloEta = -caloEta;
       int caloPhi = ((random()+1) % 72); // Distribute uniformly in all phi
       while(caloPhi < 1 || caloPhi > 72) caloPhi = ((random()+1) % 72);
+      if(et == 0) continue; // Zero ET TPs are not loaded, as in the producer
       UCTTowerIndex t = UCTTowerIndex(caloEta, caloPhi);
       if(!uctLayer1.setECALData(t, fg, et)) {
 	std::cerr << "UCT: Failed loading an ECAL tower" << std::endl;
 	exit(1);
       }
+      ecalTPs[0].push_back(caloEta);
+      ecalTPs[1].push_back(caloPhi);
+      ecalTPs[2].push_back(et);
+      ecalTPs[3].push_back(fg);
       expectedTotalET += et;
     }
 
@@ -128,11 +717,16 @@ int main(int argc, char** argv) {
       if((random() & 0x1) != 0) caloEta = -caloEta;
       int caloPhi = ((random()+1) % 72); // Distribute uniformly in all phi
       while(caloPhi < 1 || caloPhi > 72) caloPhi = ((random()+1) % 72);
+      if(et == 0) continue; // Zero ET TPs are not loaded, as in the producer
       UCTTowerIndex t = UCTTowerIndex(caloEta, caloPhi);
       if(!uctLayer1.setHCALData(t, et, fb)) {
 	std::cerr << "UCT: Failed loading an HCAL tower" << std::endl;
 	exit(1);
       }
+      hcalTPs[0].push_back(caloEta);
+      hcalTPs[1].push_back(caloPhi);
+      hcalTPs[2].push_back(et);
+      hcalTPs[3].push_back(fb);
       expectedTotalET += et;
     }
       
@@ -154,6 +748,101 @@ int main(int argc, char** argv) {
 		<< expectedTotalET << std::endl;
     }
 
+    // Check that the event state survives snapshot/restore and cloning
+    if((event % 100) == 0 && !checkSnapshot(uctLayer1)) {
+      std::cerr << "UCT: Snapshot/restore mismatch" << std::endl;
+      exit(1);
+    }
+
+    // Check that processing crate by crate agrees
+    if((event % 100) == 0 && !checkCrateProcessing(uctLayer1)) {
+      std::cerr << "UCT: Crate processing mismatch" << std::endl;
+      exit(1);
+    }
+
+    // Check that the bulk TP setters reproduce the event
+    if((event % 100) == 0 && !checkBulkTPs(uctLayer1, ecalTPs, hcalTPs)) {
+      std::cerr << "UCT: Bulk TP setting mismatch" << std::endl;
+      exit(1);
+    }
+
+    // Check that replaying the input links reproduces the event
+    if((event % 100) == 0 && !checkLinkUnpacker(uctLayer1)) {
+      std::cerr << "UCT: Input link replay mismatch" << std::endl;
+      exit(1);
+    }
+
+    // Check the global sums
+    if((event % 100) == 0 && !checkGlobalSums(uctLayer1, globalSums)) {
+      std::cerr << "UCT: Global sum mismatch" << std::endl;
+      globalSums.print();
+      exit(1);
+    }
+    if((event % 100) == 0 && !checkForwardGlobalSums(uctLayer1)) {
+      std::cerr << "UCT: Global sum mismatch with HF deposits" << std::endl;
+      exit(1);
+    }
+
+    // Check the eta ring sums and the pileup estimate
+    pileupEstimator.update();
+    updatePileupReference(uctLayer1, pileupReference, pileupEstimator.getAverageShift());
+    if((event % 100) == 0 && !checkRingSums(uctLayer1, pileupEstimator, pileupReference)) {
+      std::cerr << "UCT: Eta ring sum mismatch" << std::endl;
+      exit(1);
+    }
+
+    // Check the tower history of this and the previous crossing
+    if(!checkTowerHistory(uctLayer1, towerHistory, previousET)) {
+      std::cerr << "UCT: Tower history mismatch" << std::endl;
+      exit(1);
+    }
+
+    // Check delta processing against full processing
+    if((event % 10) == 0 && !checkDeltaProcessing(uctLayer1, deltaLayer1, ecalTPs, hcalTPs)) {
+      std::cerr << "UCT: Delta processing mismatch" << std::endl;
+      exit(1);
+    }
+
+    // Check channel masking
+    if((event % 100) == 0 && !checkChannelMask(uctLayer1, ecalTPs)) {
+      std::cerr << "UCT: Channel mask mismatch" << std::endl;
+      exit(1);
+    }
+
+    // Check the layer-wide region veto bits
+    if((event % 10) == 0 && !checkRegionVeto(uctLayer1)) {
+      std::cerr << "UCT: Region veto bit mismatch" << std::endl;
+      exit(1);
+    }
+
+    // Check the veto threshold scan
+    if(!checkThresholdScan(uctLayer1, thresholdScan)) {
+      std::cerr << "UCT: Threshold scan mismatch" << std::endl;
+      thresholdScan.print();
+      exit(1);
+    }
+
+    // Check the tower summed-area table
+    if((event % 100) == 0 && !checkTowerSumTable(uctLayer1)) {
+      std::cerr << "UCT: Tower sum table mismatch" << std::endl;
+      exit(1);
+    }
+
+    // Check the calibration LUTs
+    if((event % 1000) == 0 && !checkCalibrationLUT(uctLayer1)) {
+      std::cerr << "UCT: Calibration LUT mismatch" << std::endl;
+      exit(1);
+    }
+
+  }
+
+  // The looser and tighter thresholds must have moved the counts
+  const std::vector<uint64_t>& eg = thresholdScan.getTotalEGCounts();
+  const std::vector<uint64_t>& tau = thresholdScan.getTotalTauCounts();
+  if(nEvents >= 100 && (eg[1] <= eg[0] || eg[0] <= eg[2] || tau[1] <= tau[0] || tau[0] <= tau[2])) {
+    std::cerr << "UCT: Threshold scan counts do not depend on the thresholds" << std::endl;
+    thresholdScan.print();
+    exit(1);
   }
 
   return 0;
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <map>
+#include <vector>
+#include <thread>
+#include <cmath>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+
+using namespace std;
+
+#include "L1Trigger/L1TCaloLayer1/src/UCTMetrics.hh"
+
+// Updates metrics from several threads while the writer thread rewrites
+// the file, then checks the final file against the expected totals
+
+// Samples of the file by name with labels, e.g. x_bucket{le="0.001"}
+
+bool readSamples(const string& fileName, map<string, double>& samples) {
+  ifstream file(fileName.c_str());
+  if(!file) return false;
+  string line;
+  while(getline(file, line)) {
+    if(line.empty() || line[0] == '#') continue;
+    size_t space = line.rfind(' ');
+    if(space == string::npos) return false;
+    samples[line.substr(0, space)] = atof(line.substr(space + 1).c_str());
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+
+  string fileName = "testUCTMetrics.prom";
+  uint32_t nThreads = 4;
+  uint32_t nUpdates = 1000000;
+  if(argc > 1) fileName = argv[1];
+  if(argc > 2) {
+    cout << "Command syntax: testUCTMetrics [metricsFile]" << endl;
+    return 1;
+  }
+
+  UCTMetrics* metrics = new UCTMetrics(fileName, 1);
+  uint32_t events = metrics->addCounter("test_events_total", "Events");
+  uint32_t input = metrics->addCounter("test_stage_seconds_total", "Time per stage", "stage=\"input\"", 1e-9);
+  uint32_t process = metrics->addCounter("test_stage_seconds_total", "", "stage=\"process\"", 1e-9);
+  uint32_t level = metrics->addGauge("test_level", "Last level");
+  double bounds[] = {1e-6, 1e-5, 1e-4};
+  uint32_t latency = metrics->addHistogram("test_event_seconds", "Time per event",
+					   vector<double>(bounds, bounds + 3), 1e-9);
+  if(!metrics->start()) return 1;
+
+  // Latencies of 0.5, 5, 50 and 500 us fill one bucket each
+  vector<thread> threads;
+  for(uint32_t t = 0; t < nThreads; t++) {
+    threads.push_back(thread([=]() {
+	  uint64_t latencies[] = {500, 5000, 50000, 500000};
+	  for(uint32_t i = 0; i < nUpdates; i++) {
+	    metrics->add(events);
+	    metrics->add(input, 1000);
+	    metrics->add(process, 2000);
+	    metrics->observe(latency, latencies[i % 4]);
+	    if((i % 100000) == 0) usleep(200000);
+	  }
+	}));
+  }
+  for(uint32_t t = 0; t < nThreads; t++) threads[t].join();
+  metrics->set(level, 42);
+
+  // The final values are written when the metrics are destroyed
+  delete metrics;
+
+  map<string, double> samples;
+  if(!readSamples(fileName, samples)) {
+    cerr << "testUCTMetrics: Cannot read " << fileName << endl;
+    return 1;
+  }
+  double n = (double) nThreads * nUpdates;
+  map<string, double> expected;
+  expected["test_events_total"] = n;
+  expected["test_stage_seconds_total{stage=\"input\"}"] = n * 1000 * 1e-9;
+  expected["test_stage_seconds_total{stage=\"process\"}"] = n * 2000 * 1e-9;
+  expected["test_level"] = 42;
+  expected["test_event_seconds_bucket{le=\"1e-06\"}"] = n / 4;
+  expected["test_event_seconds_bucket{le=\"1e-05\"}"] = n / 2;
+  expected["test_event_seconds_bucket{le=\"0.0001\"}"] = 3 * n / 4;
+  expected["test_event_seconds_bucket{le=\"+Inf\"}"] = n;
+  expected["test_event_seconds_count"] = n;
+  expected["test_event_seconds_sum"] = n / 4 * (500 + 5000 + 50000 + 500000) * 1e-9;
+  bool success = (samples.size() == expected.size());
+  for(map<string, double>::const_iterator e = expected.begin(); e != expected.end(); ++e) {
+    map<string, double>::const_iterator s = samples.find(e->first);
+    if(s == samples.end() || fabs(s->second - e->second) > 1e-9 * fabs(e->second)) {
+      cerr << "testUCTMetrics: " << e->first << " is " << (s == samples.end() ? "missing" : "wrong")
+	   << "; expected " << e->second << endl;
+      success = false;
+    }
+  }
+  if(!success) return 1;
+  cout << "testUCTMetrics: " << samples.size() << " samples in " << fileName << " as expected" << endl;
+  return 0;
+
+}
@@ -0,0 +1,52 @@
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <stdint.h>
+
+using namespace std;
+
+#include "L1Trigger/L1TCaloLayer1/src/UCTLayer1.hh"
+#include "L1Trigger/L1TCaloLayer1/src/UCTSummaryCard.hh"
+
+#include "L1Trigger/L1TCaloLayer1/src/UCTGeometry.hh"
+
+bool check(bool condition, const char* what) {
+  if(!condition) cerr << "testUCTSummaryCard: " << what << " failed" << endl;
+  return condition;
+}
+
+int main(int argc, char** argv) {
+
+  UCTGeometry g;
+  UCTLayer1 uct;
+  UCTSummaryCard summaryCard(uct);
+  bool ok = true;
+
+  // Single isolated electron-like deposit
+
+  uct.clearEvent();
+  uct.setECALData(UCTTowerIndex(-10, 30), false, 60);
+  uct.process();
+  summaryCard.process();
+  UCTRegionIndex r = g.getUCTRegionIndex(-10, 30);
+  const vector<UCTSummaryObject>& jets = summaryCard.getJets();
+  ok &= check(jets.size() == 1, "single deposit jet count");
+  ok &= check(jets.size() == 1 && jets[0].index == r && jets[0].et == 60, "single deposit jet position");
+  const vector<UCTSummaryObject>& egs = summaryCard.getEGCandidates();
+  ok &= check(egs.size() == 1 && egs[0].index == r && egs[0].isolated, "single deposit EG candidate");
+
+  // Deposit split across the phi boundary is found once, with the full ET
+
+  uct.clearEvent();
+  uct.setECALData(UCTTowerIndex(5, MaxCaloPhi - 3), false, 50);
+  uct.setHCALData(UCTTowerIndex(5, 1), 40, 0);
+  uct.process();
+  summaryCard.process();
+  ok &= check(summaryCard.getJets().size() == 1, "phi wraparound jet count");
+  ok &= check(summaryCard.getJets().size() == 1 && summaryCard.getJets()[0].et == 90, "phi wraparound jet ET");
+
+  if(!ok) return 1;
+  summaryCard.print();
+  return 0;
+
+}